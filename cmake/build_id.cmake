@@ -0,0 +1,14 @@
+# Computes an identifier of the build of the compiler, from its sources, the libraries it is linked
+# with, and the given description of the toolchain. Cache entries stored by another build are never
+# used (see `cache_key` in main.cpp). The header is only written when the identifier changes, so
+# that the compiler is not rebuilt needlessly.
+set(build_id "${BUILD_ID_TOOLCHAIN}")
+foreach (file ${BUILD_ID_FILES})
+    if (EXISTS ${file})
+        file(SHA256 ${file} file_hash)
+        string(APPEND build_id ";${file_hash}")
+    endif ()
+endforeach ()
+string(SHA256 build_id "${build_id}")
+file(WRITE ${BUILD_ID_HEADER}.tmp "#define ARTIC_BUILD_ID \"${build_id}\"\n")
+configure_file(${BUILD_ID_HEADER}.tmp ${BUILD_ID_HEADER} COPYONLY)
@@ -236,6 +236,19 @@ struct PathAttr : public Attr {
     void print(Printer&) const override;
 };
 
+/// Attribute with an associated type.
+struct TypeAttr : public Attr {
+    Ptr<Type> type;
+
+    TypeAttr(const Loc& loc, std::string&& name, Ptr<Type>&& type)
+        : Attr(loc, std::move(name)), type(std::move(type))
+    {}
+
+    void check(TypeChecker&, const ast::Node*) override;
+    void bind(NameBinder&) override;
+    void print(Printer&) const override;
+};
+
 /// Attribute with an associated literal.
 struct LiteralAttr : public Attr {
     Literal lit;
@@ -372,10 +385,11 @@ struct FnType : public Type {
 struct PtrType : public Type {
     Ptr<Type> pointee;
     bool is_mut;
+    bool is_noalias;
     size_t addr_space;
 
-    PtrType(const Loc& loc, Ptr<Type>&& pointee, bool is_mut, size_t addr_space)
-        : Type(loc), pointee(std::move(pointee)), is_mut(is_mut), addr_space(addr_space)
+    PtrType(const Loc& loc, Ptr<Type>&& pointee, bool is_mut, bool is_noalias, size_t addr_space)
+        : Type(loc), pointee(std::move(pointee)), is_mut(is_mut), is_noalias(is_noalias), addr_space(addr_space)
     {}
 
     const artic::Type* infer(TypeChecker&) override;
@@ -727,6 +741,9 @@ struct IfExpr : public Expr {
     Ptr<Expr> if_true;
     Ptr<Expr> if_false;
 
+    // Set during type-checking
+    mutable std::vector<const struct PtrnDecl*> written_vars;
+
     IfExpr(
         const Loc& loc,
         Ptr<Expr>&& cond,
@@ -777,6 +794,9 @@ struct MatchExpr : public Expr {
     Ptr<Expr> arg;
     PtrVector<CaseExpr> cases;
 
+    // Set during type-checking
+    mutable std::vector<const struct PtrnDecl*> written_vars;
+
     MatchExpr(const Loc& loc, Ptr<Expr>&& arg, PtrVector<CaseExpr>&& cases)
         : Expr(loc)
         , arg(std::move(arg))
@@ -795,6 +815,10 @@ struct MatchExpr : public Expr {
 
 /// Base class for loop expressions (while, for)
 struct LoopExpr : public Expr {
+    // Set during type-checking
+    mutable std::vector<const struct PtrnDecl*> written_vars;
+    mutable bool has_indirect_jumps = false;
+
     // Set during IR emission
     mutable const thorin::Def* break_ = nullptr;
     mutable const thorin::Def* continue_ = nullptr;
@@ -1136,6 +1160,10 @@ struct PtrnDecl : public NamedDecl {
 
     // Set during type-checking.
     mutable bool written_to = false;
+    // Mutable variables that are neither captured by a closure nor
+    // accessed by address keep this flag, and are emitted as SSA values
+    // instead of memory slots.
+    mutable bool is_ssa = true;
 
     PtrnDecl(const Loc& loc, Identifier&& id, bool is_mut = false)
         : NamedDecl(loc, std::move(id)), is_mut(is_mut)
@@ -1193,6 +1221,11 @@ struct FnDecl : public NamedDecl {
     Ptr<FnExpr> fn;
     Ptr<TypeParamList> type_params;
 
+    /// Tokens of the body, if it has not been parsed yet (see `Parser::lazy_fn_bodies`).
+    std::vector<Token> lazy_body;
+    /// Set by the name binder when the function is referenced.
+    bool is_used = false;
+
     FnDecl(
         const Loc& loc,
         Identifier&& id,
@@ -2,6 +2,7 @@
 #define ARTIC_BIND_H
 
 #include <unordered_map>
+#include <unordered_set>
 #include <string_view>
 #include <vector>
 #include <algorithm>
@@ -32,6 +33,18 @@ public:
     void bind_head(ast::Decl&);
     void bind(ast::Node&);
 
+    /// Marks the given function as used. If its body has not been parsed and
+    /// the function has already been visited, it is bound by `bind_used_fns`.
+    void use_fn(ast::FnDecl&);
+    /// Records that the given function has been visited, but not bound,
+    /// because its body has not been parsed and it is not used yet.
+    void defer_fn(ast::FnDecl& fn_decl) { deferred_fns_.insert(&fn_decl); }
+    /// Binds the deferred functions that are used, until no other function is used.
+    /// Returns the functions that are still not used, the bodies of which are never parsed.
+    std::unordered_set<ast::FnDecl*> bind_used_fns();
+    /// Parses the body of the given function from the tokens recorded by the parser.
+    void parse_lazy_body(ast::FnDecl&);
+
     ast::FnExpr* cur_fn() const { return cur_fn_; }
     ast::FnExpr* push_fn(ast::FnExpr* fn) {
         auto old = cur_fn_;
@@ -87,6 +100,8 @@ private:
     ast::FnExpr*   cur_fn_;
     ast::LoopExpr* cur_loop_;
     std::vector<SymbolTable> scopes_;
+    std::unordered_set<ast::FnDecl*> deferred_fns_;
+    std::vector<ast::FnDecl*> used_fns_;
 };
 
 } // namespace artic
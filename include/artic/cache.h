@@ -0,0 +1,46 @@
+#ifndef ARTIC_CACHE_H
+#define ARTIC_CACHE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace artic {
+
+/// On-disk cache of the files emitted by the compiler. Entries are identified by a key,
+/// which contains every input of the compiler. Each entry is a directory named after
+/// a hash of the key (see `fnv::Hash`), which contains the emitted files and the key.
+/// The key is compared upon restoration, so that entries that only have the same
+/// hash are never used. The least recently used entries are evicted when the total
+/// size of the cache exceeds its maximum size. The cache may be shared by several
+/// processes: entries are written to a temporary directory and then renamed.
+struct Cache {
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t entries = 0;
+        size_t size = 0;
+    };
+
+    Cache(const std::string& dir, size_t max_size)
+        : dir(dir), max_size(max_size)
+    {}
+
+    std::string dir;
+    size_t max_size;
+
+    /// Restores the files of the entry with the given key, replacing the stem of each
+    /// file with the given module name. Returns true on a hit, and records the lookup.
+    bool restore(const std::string& key, const std::string& module_name) const;
+    /// Stores the files named after the module name followed by the given
+    /// extensions (e.g. `.ll`) under the given key, and evicts old entries.
+    /// Returns false if the entry could not be written.
+    bool store(const std::string& key, const std::string& module_name, const std::vector<std::string>& exts) const;
+    /// Returns the number of hits and misses recorded so far, along
+    /// with the number of entries and the total size of the cache.
+    Stats stats() const;
+};
+
+} // namespace artic
+
+#endif // ARTIC_CACHE_H
@@ -2,6 +2,8 @@
 #define ARTIC_CHECK_H
 
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
 #include <optional>
 
 #include "artic/ast.h"
@@ -76,10 +78,35 @@ public:
 
     bool infer_type_args(const Loc&, const ForallType*, const Type*, std::vector<const Type*>&);
 
+    // Some arguments of built-in functions (such as memory orders) have to be constants
+    void check_builtin_args(const ast::Path&, const ast::Expr&);
+
+    // Used to determine which mutable variables can be promoted to SSA values.
+    // Regions are the expressions that capture (functions), merge (if, match, loops),
+    // or conditionally evaluate (logical operators, jump arguments) the variables they contain.
+    void enter_region(const ast::Expr*);
+    void exit_region();
+    void decl_var(const ast::PtrnDecl&);
+    void use_var(const ast::PtrnDecl&);
+    void read_var(const ast::Expr&);
+    void write_var(const ast::Expr&);
+    void register_jump(const ast::LoopExpr&, const ast::Expr&);
+
 private:
+    struct VarInfo {
+        size_t depth;
+        size_t unknown_uses;
+    };
+
     std::unordered_set<const ast::Decl*> decls_;
+    std::unordered_map<const ast::PtrnDecl*, VarInfo> vars_;
+    std::vector<const ast::Expr*> regions_;
 };
 
+/// Checks the signature of the built-in function with the given name. Type variables stand
+/// for any type, so that both declarations and their instances can be checked.
+bool is_valid_builtin(const std::string&, const Type*);
+
 } // namespace artic
 
 #endif // ARTIC_CHECK_H
@@ -2,6 +2,8 @@
 #define ARTIC_EMIT_H
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <cassert>
 
 #include <thorin/util/location.h>
@@ -10,6 +12,7 @@
 #include "artic/types.h"
 #include "artic/log.h"
 #include "artic/hash.h"
+#include "artic/hints.h"
 
 namespace thorin {
     class World;
@@ -28,11 +31,34 @@ public:
         : Logger(log), world(world)
     {}
 
+    /// Clears the definitions attached to the AST during emission, which belong to the
+    /// world. This allows emitting the same AST again, in another world.
+    ~Emitter() {
+        for (auto def : ast_defs)
+            *def = nullptr;
+    }
+
     thorin::World& world;
 
+    /// When set, only the declarations that are reachable from
+    /// exported functions are emitted (see `ast::ModDecl::emit`).
+    bool only_reachable = false;
+    /// When set, instances of polymorphic functions whose type arguments are pointers
+    /// that are only passed through share the same code (see `ast::FnDecl::emit`).
+    bool share_ptr_instances = false;
+    /// When set, prints the instances of every polymorphic function after emission.
+    bool mono_report = false;
+    /// Size in bytes from which structures, tuples, and arrays are passed to
+    /// functions through read-only pointers (see `ast::FnDecl::emit`), or zero to disable.
+    size_t by_ref_threshold = 64;
+
     struct State {
         const thorin::Def* mem = nullptr;
         thorin::Continuation* cont = nullptr;
+        /// Current values of the mutable variables that are promoted to SSA values.
+        std::unordered_map<const ast::PtrnDecl*, const thorin::Def*> vars;
+        /// Fast-math flags in effect, each followed by a dot (see `LLVMHints::fast_math_prefix`).
+        std::string fast_math;
     };
 
     struct SavedState {
@@ -92,12 +118,28 @@ public:
     std::unordered_map<const TypeVar*, const Type*> type_vars;
     /// Map from monomorphic function signature to emitted thorin function.
     std::unordered_map<MonoFn, thorin::Continuation*, Hash, Compare> mono_fns;
+    /// Map from monomorphized function to the location of its first use.
+    std::unordered_map<const thorin::Continuation*, Loc> mono_locs;
     /// Map from enum type and variant index to variant constructor.
     std::unordered_map<Ctor, const thorin::Def*, Hash, Compare> variant_ctors;
     /// Vector containing definitions that are generated during monomorphization.
     std::vector<std::vector<const thorin::Def**>> poly_defs;
+    /// Definitions attached to the AST during emission.
+    std::vector<const thorin::Def**> ast_defs;
+    /// Hints for the LLVM backend that cannot be expressed in Thorin IR.
+    LLVMHints hints;
+    /// Map from join point to the promoted variables passed as extra parameters.
+    std::unordered_map<const thorin::Def*, std::vector<const ast::PtrnDecl*>> join_vars;
+    /// Map from the imported functions that are only lowered in host code (see `check_device_code`)
+    /// to a description and the location of the first built-in function or operation that calls them.
+    std::unordered_map<std::string, std::pair<std::string, Loc>> host_only_fns;
+    /// Map from the alignment of structures and fields marked with `#[align = N]`
+    /// to the location of the first declaration that uses it (see `check_device_code`).
+    std::unordered_map<size_t, Loc> align_locs;
 
     bool run(const ast::ModDecl&);
+    bool check_device_code(thorin::World&, const std::string&, bool);
+    void report_mono_fns();
 
     SavedState save_state() { return SavedState(*this); }
 
@@ -107,6 +149,8 @@ public:
     thorin::Continuation* basic_block(thorin::Debug = {});
     thorin::Continuation* basic_block_with_mem(thorin::Debug = {});
     thorin::Continuation* basic_block_with_mem(const thorin::Type*, thorin::Debug = {});
+    thorin::Continuation* join_block(const thorin::Type*, const std::vector<const ast::PtrnDecl*>&, thorin::Debug = {});
+    const thorin::Def* forward_vars(const thorin::Def*);
 
     const thorin::Def* ctor_index(const EnumType*, size_t);
     const thorin::Def* ctor_index(const ast::EnumPtrn& enum_ptrn) {
@@ -124,6 +168,7 @@ public:
     const thorin::FnType* function_type_with_mem(const thorin::Type*, const thorin::Type*);
     const thorin::Def* tuple_from_params(thorin::Continuation*, bool = false);
     std::vector<const thorin::Def*> call_args(const thorin::Def*, const thorin::Def*, const thorin::Def* = nullptr);
+    std::vector<const thorin::Def*> join_args(const thorin::Def*, std::vector<const thorin::Def*>&&);
 
     void enter(thorin::Continuation*);
     void jump(const thorin::Def*, thorin::Debug = {});
@@ -139,10 +184,12 @@ public:
 
     const thorin::Def* no_ret();
     const thorin::Def* down_cast(const thorin::Def*, const Type*, const Type*, thorin::Debug = {});
+    const thorin::Def* layout_cast(const thorin::Def*, const Type*, const Type*, thorin::Debug = {});
 
     const thorin::Def* emit(const ast::Node&);
     void emit(const ast::Ptrn&, const thorin::Def*);
     void bind(const ast::IdPtrn&, const thorin::Def*);
+    const ast::PtrnDecl* ssa_var(const ast::Expr&);
     const thorin::Def* emit(const ast::Node&, const Literal&);
 
     const thorin::Def* builtin(const ast::FnDecl&, thorin::Continuation*);
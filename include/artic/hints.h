@@ -0,0 +1,59 @@
+#ifndef ARTIC_HINTS_H
+#define ARTIC_HINTS_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+namespace thorin {
+    class World;
+    class Continuation;
+}
+
+namespace llvm {
+    class Module;
+}
+
+namespace artic {
+
+/// Optimization hints that cannot be represented in Thorin IR. They are
+/// attached to the LLVM module generated from the world, before it is optimized.
+struct LLVMHints {
+    /// LLVM function attributes (e.g. `noinline`) of each continuation.
+    std::unordered_map<const thorin::Continuation*, std::vector<std::string>> fn_attrs;
+    /// LLVM parameter attributes (e.g. `noalias`) of each continuation, along with
+    /// the index of the parameter they apply to in the generated LLVM function.
+    std::unordered_map<const thorin::Continuation*, std::vector<std::pair<size_t, std::string>>> param_attrs;
+    /// LLVM loop metadata (e.g. `llvm.loop.unroll.count` with the operand `4`) of the loop containing
+    /// each continuation. The continuation is either the loop header, or a block in its body.
+    /// Operands are booleans for names ending with `.enable`, and 32-bit integers otherwise.
+    std::unordered_map<const thorin::Continuation*, std::vector<std::pair<std::string, std::optional<unsigned>>>> loop_md;
+    /// Target CPU and features (e.g. `+avx2,+fma`) of every function
+    /// defined in the module. Empty strings keep the defaults.
+    std::string target_cpu, target_features;
+    /// LLVM fast-math flags (e.g. `nnan`) of every floating-point operation in the module.
+    std::vector<std::string> fast_math;
+
+    /// Prefix of the placeholder functions called for the floating-point operations that have
+    /// their own fast-math flags. The name of the operation, the flags, and the type of the
+    /// operands follow the prefix and are separated by dots (e.g. `fast_math.fmul.nnan.ninf.f32`).
+    static constexpr const char* fast_math_prefix = "fast_math.";
+    /// Prefix of the placeholder functions called for non-temporal loads and stores, which is followed
+    /// by `load.` or `store.` and a name that is unique to each type (e.g. `nontemporal.load.load_nt_42`).
+    static constexpr const char* nontemporal_prefix = "nontemporal.";
+    /// Prefix of the placeholder functions called for prefetches, which is followed by a name that is unique to
+    /// each type (e.g. `prefetch.prefetch_42`). The intrinsic is only declared once the pointer type is known in LLVM.
+    static constexpr const char* prefetch_prefix = "prefetch.";
+    /// Fast-math flags that are supported by LLVM.
+    static constexpr const char* fast_math_flags[] = { "fast", "nnan", "ninf", "nsz", "arcp", "contract", "afn", "reassoc" };
+
+    /// Adds the hints to the given LLVM module, generated from the given world.
+    /// Hints attached to continuations that have been removed by the optimizer are ignored.
+    void apply(thorin::World&, llvm::Module&) const;
+};
+
+} // namespace artic
+
+#endif // ARTIC_HINTS_H
@@ -0,0 +1,43 @@
+#ifndef ARTIC_MODULE_H
+#define ARTIC_MODULE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "artic/ast.h"
+
+namespace artic {
+
+/// Module (`.artm` file), containing the declarations of a set of source files as they are
+/// after parsing, along with the contents of these files, which are needed to report diagnostics.
+/// The file starts with a magic number, the version of the format, and a checksum of the rest of
+/// the file. It contains no pointer, so that it can be read directly from memory.
+///
+/// Modules only save the time spent lexing and parsing: Declarations are name-bound and
+/// type-checked again once loaded. The types of the type table are not stored, because they
+/// refer to the AST (declarations of structures, enumerations and type variables), and because
+/// type-checking also modifies the AST (e.g. implicit casts, or variables promoted to SSA values).
+struct ModuleFile {
+    /// Version of the format, which must be incremented whenever the AST changes.
+    static constexpr uint32_t version = 1;
+
+    std::vector<std::string> files;
+    std::vector<std::string> contents;
+    PtrVector<ast::Decl> decls;
+
+    /// Serializes the given declarations, which must not have been
+    /// name-bound or type-checked yet, into the contents of a module file.
+    static std::string write(
+        const std::vector<std::string>& files,
+        const std::vector<std::string_view>& contents,
+        const std::vector<const ast::Decl*>& decls);
+    /// Reads the given contents of a module file. Returns nothing if the
+    /// contents are not a valid module file for this version of the format.
+    static std::unique_ptr<ModuleFile> read(std::string_view data);
+};
+
+} // namespace artic
+
+#endif // ARTIC_MODULE_H
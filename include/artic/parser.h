@@ -18,15 +18,24 @@ namespace artic {
 class Parser : public Logger {
 public:
     Parser(Log& log, Lexer&);
+    /// Creates a parser that reads the given tokens, which are followed by the end of the file.
+    Parser(Log& log, std::vector<Token>&&);
+
+    /// When set, the bodies of the functions declared at the top level of the
+    /// file are not parsed. Their tokens are recorded in the declaration instead,
+    /// and parsed by the name binder when the function is used (see `parse_lazy_body`).
+    bool lazy_fn_bodies = false;
 
     /// Parses a program read from the Lexer object.
     /// Errors are reported by the Logger.
     Ptr<ast::ModDecl> parse();
+    /// Parses the body of a function, from the tokens recorded with `lazy_fn_bodies`.
+    Ptr<ast::BlockExpr> parse_lazy_body();
 
 private:
     Ptr<ast::Decl>          parse_decl(bool = false);
     Ptr<ast::LetDecl>       parse_let_decl();
-    Ptr<ast::FnDecl>        parse_fn_decl();
+    Ptr<ast::FnDecl>        parse_fn_decl(bool = false);
     Ptr<ast::FieldDecl>     parse_field_decl();
     Ptr<ast::StructDecl>    parse_struct_decl();
     Ptr<ast::OptionDecl>    parse_option_decl();
@@ -199,7 +208,12 @@ private:
         prev_ = ahead_[0].loc();
         for (int i = 0; i < max_ahead - 1; i++)
             ahead_[i] = ahead_[i + 1];
-        ahead_[max_ahead - 1] = lexer_.next();
+        if (lexer_)
+            ahead_[max_ahead - 1] = lexer_->next();
+        else if (next_token_ < tokens_.size())
+            ahead_[max_ahead - 1] = tokens_[next_token_++];
+        else
+            ahead_[max_ahead - 1] = Token(tokens_.back().loc().at_end(), Token::End);
     }
 
     const Token& ahead(int i = 0) const {
@@ -210,7 +224,9 @@ private:
     static constexpr int max_ahead = 3;
 
     Token ahead_[max_ahead];
-    Lexer& lexer_;
+    Lexer* lexer_;
+    std::vector<Token> tokens_;
+    size_t next_token_ = 0;
     Loc prev_;
 };
 
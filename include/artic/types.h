@@ -231,14 +231,21 @@ struct AddrType : public Type {
 };
 
 /// A pointer type, as the result of taking the address of an object.
+/// A `noalias` pointer promises that the memory it points to is not
+/// accessed through any other pointer while the pointer is live.
 struct PtrType : public AddrType {
+    bool is_noalias;
+
+    bool equals(const Type*) const override;
+    size_t hash() const override;
+
     void print(Printer&) const override;
     const Type* replace(const std::unordered_map<const TypeVar*, const Type*>&) const override;
     const thorin::Type* convert(Emitter&) const override;
 
 private:
-    PtrType(TypeTable& type_table, const Type* pointee, bool is_mut, size_t addr_space)
-        : AddrType(type_table, pointee, is_mut, addr_space)
+    PtrType(TypeTable& type_table, const Type* pointee, bool is_mut, size_t addr_space, bool is_noalias)
+        : AddrType(type_table, pointee, is_mut, addr_space), is_noalias(is_noalias)
     {}
 
     friend class TypeTable;
@@ -537,6 +544,7 @@ bool is_int_or_float_type(const Type*);
 bool is_prim_type(const Type*, ast::PrimType::Tag);
 bool is_simd_type(const Type*);
 bool is_unit_type(const Type*);
+bool is_soa_type(const Type*);
 inline bool is_bool_type(const Type* type) { return is_prim_type(type, ast::PrimType::Bool); }
 
 template <typename T>
@@ -557,7 +565,7 @@ public:
     const TupleType*        tuple_type(std::vector<const Type*>&&);
     const SizedArrayType*   sized_array_type(const Type*, size_t, bool);
     const UnsizedArrayType* unsized_array_type(const Type*);
-    const PtrType*          ptr_type(const Type*, bool, size_t);
+    const PtrType*          ptr_type(const Type*, bool, size_t, bool = false);
     const RefType*          ref_type(const Type*, bool, size_t);
     const FnType*           fn_type(const Type*, const Type*);
     const FnType*           cn_type(const Type*);
@@ -575,6 +583,12 @@ public:
     /// or returns the type alias expanded with the given type arguments.
     const Type* type_app(const UserType*, std::vector<const Type*>&&);
 
+    /// Returns a checkpoint, to which the table can be rolled back with `rollback()`.
+    size_t checkpoint() const { return order_.size(); }
+    /// Destroys the types that have been created after the given checkpoint,
+    /// which must no longer be referenced (by the AST or by other types).
+    void rollback(size_t);
+
 private:
     template <typename T, typename... Args>
     const T* insert(Args&&...);
@@ -590,6 +604,8 @@ private:
         }
     };
     std::unordered_set<const Type*, HashType, CompareTypes> types_;
+    /// Types in the order in which they have been created.
+    std::vector<const Type*> order_;
 
     const PrimType*   bool_type_   = nullptr;
     const TupleType*  unit_type_   = nullptr;
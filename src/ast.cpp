@@ -267,6 +267,7 @@ BinaryExpr::Tag BinaryExpr::tag_from_token(const Token& token) {
 }
 
 void CaseExpr::collect_bound_ptrns() const {
+    bound_ptrns.clear();
     ptrn->collect_bound_ptrns(bound_ptrns);
 }
 
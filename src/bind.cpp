@@ -1,5 +1,6 @@
 #include "artic/bind.h"
 #include "artic/ast.h"
+#include "artic/parser.h"
 
 namespace artic {
 
@@ -18,6 +19,34 @@ void NameBinder::bind(ast::Node& node) {
     node.bind(*this);
 }
 
+void NameBinder::use_fn(ast::FnDecl& fn_decl) {
+    if (fn_decl.is_used)
+        return;
+    fn_decl.is_used = true;
+    if (deferred_fns_.erase(&fn_decl))
+        used_fns_.push_back(&fn_decl);
+}
+
+std::unordered_set<ast::FnDecl*> NameBinder::bind_used_fns() {
+    while (!used_fns_.empty()) {
+        auto fn_decl = used_fns_.back();
+        used_fns_.pop_back();
+        fn_decl->bind(*this);
+    }
+    auto unused_fns = std::move(deferred_fns_);
+    deferred_fns_.clear();
+    return unused_fns;
+}
+
+void NameBinder::parse_lazy_body(ast::FnDecl& fn_decl) {
+    Parser parser(log, std::move(fn_decl.lazy_body));
+    parser.warns_as_errors = warns_as_errors;
+    fn_decl.fn->body = parser.parse_lazy_body();
+    fn_decl.lazy_body.clear();
+    errors += parser.errors;
+    warns += parser.warns;
+}
+
 void NameBinder::pop_scope() {
     for (auto& pair : scopes_.back().symbols) {
         auto decl = pair.second->decls.front();
@@ -66,7 +95,12 @@ void Path::bind(NameBinder& binder) {
         binder.error(first.id.loc, "identifiers beginning with '_' cannot be referenced");
     else {
         symbol = binder.find_symbol(first.id.name);
-        if (!symbol) {
+        if (symbol) {
+            for (auto decl : symbol->decls) {
+                if (auto fn_decl = decl->isa<FnDecl>())
+                    binder.use_fn(*fn_decl);
+            }
+        } else {
             binder.error(first.id.loc, "unknown identifier '{}'", first.id.name);
             if (auto similar = binder.find_similar_symbol(first.id.name)) {
                 auto decl = similar->decls.front();
@@ -97,6 +131,10 @@ void PathAttr::bind(NameBinder& binder) {
     binder.bind(path);
 }
 
+void TypeAttr::bind(NameBinder& binder) {
+    binder.bind(*type);
+}
+
 void NamedAttr::bind(NameBinder& binder) {
     for (auto& arg : args)
         binder.bind(*arg);
@@ -372,6 +410,13 @@ void FnDecl::bind_head(NameBinder& binder) {
 }
 
 void FnDecl::bind(NameBinder& binder) {
+    // Functions that are neither used nor exported do not need their body to be parsed, yet
+    if (!lazy_body.empty()) {
+        if (!is_used && !(attrs && attrs->find("export")))
+            return binder.defer_fn(*this);
+        binder.parse_lazy_body(*this);
+    }
+
     binder.push_scope();
     if (type_params)
         binder.bind(*type_params);
@@ -439,7 +484,16 @@ void ModDecl::bind(NameBinder& binder) {
     binder.push_scope(true);
     for (auto& decl : decls) binder.bind_head(*decl);
     for (auto& decl : decls) binder.bind(*decl);
+    // Only the top level of the program, which has no name, contains functions with lazy bodies.
+    // Those that are never used are removed, so that later passes do not see them as prototypes.
+    std::unordered_set<FnDecl*> unused_fns;
+    if (id.name.empty())
+        unused_fns = binder.bind_used_fns();
     binder.pop_scope();
+    decls.erase(std::remove_if(decls.begin(), decls.end(), [&] (const Ptr<Decl>& decl) {
+        auto fn_decl = decl->isa<FnDecl>();
+        return fn_decl && unused_fns.count(fn_decl);
+    }), decls.end());
 }
 
 void ErrorDecl::bind(NameBinder&) {}
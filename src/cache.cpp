@@ -0,0 +1,147 @@
+#include "artic/cache.h"
+#include "artic/hash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace artic {
+
+namespace fs = std::filesystem;
+
+/// Stem of the files stored in an entry, which is replaced by the module name upon restoration.
+static constexpr const char* entry_stem = "module";
+/// Name of the file that contains the key of an entry.
+static constexpr const char* key_file = "key";
+
+static std::string entry_name(const std::string& key) {
+    char name[sizeof(size_t) * 2 + 1];
+    std::snprintf(name, sizeof(name), "%016zx", size_t(fnv::Hash().combine(key)));
+    return name;
+}
+
+static bool has_key(const fs::path& path, const std::string& key) {
+    std::ifstream is(path / key_file, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    return !is.fail() && contents == key;
+}
+
+static bool is_entry(const fs::directory_entry& entry) {
+    std::error_code err;
+    auto name = entry.path().filename().string();
+    return
+        entry.is_directory(err) &&
+        name.size() == sizeof(size_t) * 2 &&
+        std::all_of(name.begin(), name.end(), [] (char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+static size_t entry_size(const fs::path& path) {
+    std::error_code err;
+    size_t size = 0;
+    for (auto& file : fs::directory_iterator(path, err)) {
+        if (auto file_size = file.file_size(err); !err)
+            size += file_size;
+    }
+    return size;
+}
+
+/// Updates the statistics of the cache. Concurrent updates may be lost,
+/// since they are not synchronized, which is acceptable for statistics.
+static void record_lookup(const fs::path& dir, bool hit) {
+    size_t hits = 0, misses = 0;
+    {
+        std::ifstream is(dir / "stats");
+        is >> hits >> misses;
+    }
+    (hit ? hits : misses)++;
+    std::ofstream os(dir / "stats");
+    os << hits << " " << misses << "\n";
+}
+
+bool Cache::restore(const std::string& key, const std::string& module_name) const {
+    std::error_code err;
+    fs::create_directories(dir, err);
+    auto path = fs::path(dir) / entry_name(key);
+    bool hit = fs::is_directory(path, err) && has_key(path, key);
+    for (auto it = fs::directory_iterator(path, err); hit && it != fs::directory_iterator(); it.increment(err)) {
+        auto name = it->path().filename().string();
+        if (name == key_file)
+            continue;
+        fs::copy_file(it->path(), module_name + name.substr(std::strlen(entry_stem)), fs::copy_options::overwrite_existing, err);
+        hit &= !err;
+    }
+    hit &= !err;
+    // The modification time of an entry is the time at which it was last used
+    if (hit)
+        fs::last_write_time(path, fs::file_time_type::clock::now(), err);
+    record_lookup(dir, hit);
+    return hit;
+}
+
+bool Cache::store(const std::string& key, const std::string& module_name, const std::vector<std::string>& exts) const {
+    std::error_code err;
+    auto path = fs::path(dir) / entry_name(key);
+    auto tmp_path = path;
+    tmp_path += ".tmp" + std::to_string(std::random_device()());
+    if (!fs::create_directories(tmp_path, err) && err)
+        return false;
+    if (!(std::ofstream(tmp_path / key_file, std::ios::binary) << key)) {
+        fs::remove_all(tmp_path, err);
+        return false;
+    }
+    for (auto& ext : exts) {
+        if (!fs::copy_file(module_name + ext, tmp_path / (entry_stem + ext), err)) {
+            fs::remove_all(tmp_path, err);
+            return false;
+        }
+    }
+    // Another process may have stored the same entry in the meantime, or an entry with another key
+    // and the same hash may exist, in which case that entry is kept and this one is not stored
+    fs::rename(tmp_path, path, err);
+    if (err) {
+        fs::remove_all(tmp_path, err);
+        return fs::is_directory(path, err) && has_key(path, key);
+    }
+
+    std::vector<std::tuple<fs::file_time_type, size_t, fs::path>> entries;
+    size_t total_size = 0;
+    for (auto& entry : fs::directory_iterator(dir, err)) {
+        if (!is_entry(entry))
+            continue;
+        auto size = entry_size(entry.path());
+        entries.emplace_back(fs::last_write_time(entry.path(), err), size, entry.path());
+        total_size += size;
+    }
+    std::sort(entries.begin(), entries.end());
+    for (auto& [time, size, entry_path] : entries) {
+        if (total_size <= max_size)
+            break;
+        if (fs::remove_all(entry_path, err) != static_cast<std::uintmax_t>(-1))
+            total_size -= size;
+    }
+    return true;
+}
+
+Cache::Stats Cache::stats() const {
+    Stats stats;
+    {
+        std::ifstream is(fs::path(dir) / "stats");
+        is >> stats.hits >> stats.misses;
+    }
+    std::error_code err;
+    for (auto& entry : fs::directory_iterator(dir, err)) {
+        if (!is_entry(entry))
+            continue;
+        stats.entries++;
+        stats.size += entry_size(entry.path());
+    }
+    return stats;
+}
+
+} // namespace artic
@@ -1,11 +1,18 @@
 #include <algorithm>
 
 #include "artic/check.h"
+#include "artic/hints.h"
 
 namespace artic {
 
 bool TypeChecker::run(ast::ModDecl& module) {
     module.infer(*this);
+    // Variables that are used in other places than plain reads and
+    // writes (e.g. to take their address) have to live in memory.
+    for (auto& [decl, info] : vars_) {
+        if (info.unknown_uses > 0)
+            decl->is_ssa = false;
+    }
     return errors == 0;
 }
 
@@ -132,8 +139,10 @@ static inline std::pair<const Type*, const Type*> remove_ptr(const Type* type) {
 
 const Type* TypeChecker::deref(Ptr<ast::Expr>& expr) {
     auto [ref_type, type] = remove_ref(infer(*expr));
-    if (ref_type)
+    if (ref_type) {
+        read_var(*expr);
         expr = make_ptr<ast::ImplicitCastExpr>(expr->loc, std::move(expr), type);
+    }
     return type;
 }
 
@@ -141,6 +150,8 @@ const Type* TypeChecker::coerce(Ptr<ast::Expr>& expr, const Type* expected) {
     auto type = expr->type ? expr->type : check(*expr, expected);
     if (type != expected) {
         if (type->subtype(expected)) {
+            if (type->isa<RefType>())
+                read_var(*expr);
             expr = make_ptr<ast::ImplicitCastExpr>(expr->loc, std::move(expr), expected);
             return expected;
         } else
@@ -162,8 +173,11 @@ const Type* TypeChecker::join(Ptr<ast::Expr>& left, Ptr<ast::Expr>& right) {
 
 const Type* TypeChecker::check(ast::Node& node, const Type* expected) {
     assert(!node.type); // Nodes can only be visited once
-    node.type = node.check(*this, expected);
-    if (node.attrs)
+    auto type = node.check(*this, expected);
+    // The default implementation of `check()` calls `infer()`, which already checks attributes
+    bool attrs_checked = node.type;
+    node.type = type;
+    if (node.attrs && !attrs_checked)
         node.attrs->check(*this, &node);
     return node.type;
 }
@@ -451,6 +465,271 @@ bool TypeChecker::infer_type_args(
     return true;
 }
 
+// Mutable variable promotion ------------------------------------------------------
+
+static inline const ast::PtrnDecl* mut_var(const ast::Expr& expr) {
+    if (auto path_expr = expr.isa<ast::PathExpr>();
+        path_expr && path_expr->path.symbol && !path_expr->path.symbol->decls.empty()) {
+        if (auto ptrn_decl = path_expr->path.symbol->decls.front()->isa<ast::PtrnDecl>();
+            ptrn_decl && ptrn_decl->is_mut)
+            return ptrn_decl;
+    }
+    return nullptr;
+}
+
+void TypeChecker::enter_region(const ast::Expr* region) {
+    regions_.push_back(region);
+}
+
+void TypeChecker::exit_region() {
+    regions_.pop_back();
+}
+
+void TypeChecker::decl_var(const ast::PtrnDecl& decl) {
+    vars_.emplace(&decl, VarInfo { regions_.size(), 0 });
+}
+
+void TypeChecker::use_var(const ast::PtrnDecl& decl) {
+    auto it = vars_.find(&decl);
+    if (it == vars_.end()) {
+        decl.is_ssa = false;
+        return;
+    }
+    // Every use is considered unknown until it is identified as a read or a write
+    it->second.unknown_uses++;
+    for (size_t i = it->second.depth, n = regions_.size(); i < n; ++i) {
+        if (regions_[i]->isa<ast::FnExpr>())
+            decl.is_ssa = false;
+    }
+}
+
+void TypeChecker::read_var(const ast::Expr& expr) {
+    if (auto decl = mut_var(expr)) {
+        if (auto it = vars_.find(decl); it != vars_.end() && it->second.unknown_uses > 0)
+            it->second.unknown_uses--;
+    }
+}
+
+void TypeChecker::write_var(const ast::Expr& expr) {
+    auto decl = mut_var(expr);
+    if (!decl)
+        return;
+    auto it = vars_.find(decl);
+    if (it == vars_.end())
+        return;
+    if (it->second.unknown_uses > 0)
+        it->second.unknown_uses--;
+
+    // Record the variable in the regions that are crossed by this write,
+    // so that its value can be merged at the end of each of them.
+    auto add_var = [decl] (std::vector<const ast::PtrnDecl*>& written_vars) {
+        if (std::find(written_vars.begin(), written_vars.end(), decl) == written_vars.end())
+            written_vars.push_back(decl);
+    };
+    for (size_t i = it->second.depth, n = regions_.size(); i < n; ++i) {
+        if (auto if_expr = regions_[i]->isa<ast::IfExpr>())
+            add_var(if_expr->written_vars);
+        else if (auto match_expr = regions_[i]->isa<ast::MatchExpr>())
+            add_var(match_expr->written_vars);
+        else if (auto loop_expr = regions_[i]->isa<ast::LoopExpr>()) {
+            add_var(loop_expr->written_vars);
+            if (loop_expr->has_indirect_jumps)
+                decl->is_ssa = false;
+        } else
+            decl->is_ssa = false;
+    }
+}
+
+void TypeChecker::register_jump(const ast::LoopExpr& loop, const ast::Expr& jump) {
+    // Jumps that are directly called pass the current values of the variables written
+    // in the loop. Other jumps may be called after those variables are modified, and so
+    // may direct calls that appear in a function nested in the loop (e.g. `|| break()`).
+    // The body of a `for` loop is itself a function, which is not crossed by its jumps.
+    auto is_direct = false;
+    if (!regions_.empty()) {
+        if (auto call_expr = regions_.back()->isa<ast::CallExpr>(); call_expr && call_expr->callee.get() == &jump)
+            is_direct = true;
+    }
+    const ast::Expr* loop_region = &loop;
+    if (auto for_expr = loop.isa<ast::ForExpr>())
+        loop_region = for_expr->call->callee->as<ast::CallExpr>()->arg.get();
+    for (auto it = regions_.rbegin(); is_direct && it != regions_.rend() && *it != loop_region; ++it) {
+        if ((*it)->isa<ast::FnExpr>())
+            is_direct = false;
+    }
+    if (is_direct)
+        return;
+    loop.has_indirect_jumps = true;
+    for (auto var : loop.written_vars)
+        var->is_ssa = false;
+}
+
+/// Returns the name of the built-in function imported by the given declaration, or an empty string.
+static std::string builtin_name(const ast::FnDecl& fn_decl) {
+    auto import_attr = fn_decl.attrs ? fn_decl.attrs->find("import") : nullptr;
+    auto cc_attr = import_attr ? import_attr->find("cc") : nullptr;
+    if (!cc_attr || !cc_attr->isa<ast::LiteralAttr>() || cc_attr->as<ast::LiteralAttr>()->lit.as_string() != "builtin")
+        return "";
+    if (auto name_attr = import_attr->find("name"); name_attr && name_attr->isa<ast::LiteralAttr>())
+        return name_attr->as<ast::LiteralAttr>()->lit.as_string();
+    return fn_decl.id.name;
+}
+
+/// Returns the arguments of a built-in function that must be integer constants, along with their
+/// allowed values. Memory orders for atomic operations are given as LLVM orderings, as in
+/// `2` (monotonic), `4` (acquire), `5` (release), `6` (acquire-release) or `7` (sequentially consistent).
+/// Prefetches take whether the access is a write (`0` or `1`), and the locality (from `0` to `3`).
+static std::vector<std::pair<size_t, std::vector<uint64_t>>> constant_builtin_args(const std::string& name) {
+    static const std::vector<uint64_t> rmw_orders = { 2, 4, 5, 6, 7 };
+    if (name == "prefetch")     return { { 1, { 0, 1 } }, { 2, { 0, 1, 2, 3 } } };
+    if (name == "fence")        return { { 0, { 4, 5, 6, 7 } } };
+    if (name == "atomic_load")  return { { 1, { 1, 2, 4, 7 } } };
+    if (name == "atomic_store") return { { 2, { 1, 2, 5, 7 } } };
+    if (name == "atomic_cas")   return { { 3, rmw_orders }, { 4, { 2, 4, 7 } } };
+    if (name.compare(0, 7, "atomic_") == 0)
+        return { { 2, rmw_orders } };
+    return {};
+}
+
+/// Returns the value of an integer literal, with or without a type annotation.
+static std::optional<uint64_t> int_literal(const ast::Expr& expr) {
+    if (auto typed_expr = expr.isa<ast::TypedExpr>())
+        return int_literal(*typed_expr->expr);
+    if (auto literal_expr = expr.isa<ast::LiteralExpr>(); literal_expr && literal_expr->lit.is_integer())
+        return literal_expr->lit.as_integer();
+    return std::nullopt;
+}
+
+/// Returns the number of bits of an integer type, or 0 if the type is not an integer type.
+static size_t int_bits(const artic::Type* type) {
+    if (!is_int_type(type))
+        return 0;
+    switch (type->as<artic::PrimType>()->tag) {
+        case ast::PrimType::I8:  case ast::PrimType::U8:  return 8;
+        case ast::PrimType::I16: case ast::PrimType::U16: return 16;
+        case ast::PrimType::I32: case ast::PrimType::U32: return 32;
+        default:                                return 64;
+    }
+}
+
+static bool is_signed_int_type(const artic::Type* type) {
+    return
+        is_prim_type(type, ast::PrimType::I8)  || is_prim_type(type, ast::PrimType::I16) ||
+        is_prim_type(type, ast::PrimType::I32) || is_prim_type(type, ast::PrimType::I64);
+}
+
+bool is_valid_builtin(const std::string& name, const artic::Type* type) {
+    if (auto forall_type = type->isa<artic::ForallType>())
+        type = forall_type->body;
+    auto fn_type = type->isa<artic::FnType>();
+    if (!fn_type)
+        return false;
+    auto tuple_type = fn_type->dom->isa<artic::TupleType>();
+    auto args = tuple_type ? tuple_type->args : std::vector<const artic::Type*> { fn_type->dom };
+    auto ptr_type = !args.empty() ? args[0]->isa<artic::PtrType>() : nullptr;
+
+    // Type variables stand for any type, since they are only known once the declaration is instantiated
+    auto is_var = [] (const artic::Type* type) { return type->isa<artic::TypeVar>(); };
+    auto elem_of = [] (const artic::Type* type) {
+        return is_simd_type(type) ? type->as<artic::SizedArrayType>()->elem : type;
+    };
+    auto is_int_like = [&] (const artic::Type* type) {
+        return is_var(type) || is_int_type(elem_of(type));
+    };
+    // Checks that the arguments and the return value all have the same type, satisfying the given predicate
+    auto is_uniform = [&] (size_t num_args, auto pred) {
+        return args.size() == num_args && pred(args[0]) &&
+            std::all_of(args.begin(), args.end(), [&] (auto arg) { return arg == args[0]; }) &&
+            fn_type->codom == args[0];
+    };
+    if (name == "popcount" || name == "clz" || name == "ctz") {
+        return is_uniform(1, is_int_like);
+    } else if (name == "bswap") {
+        // LLVM only swaps bytes of integers made of an even number of bytes
+        return is_uniform(1, [&] (const artic::Type* type) {
+            return is_var(type) || (is_int_like(type) && int_bits(elem_of(type)) % 16 == 0);
+        });
+    } else if (name == "rotl" || name == "rotr" || name == "add_sat" || name == "sub_sat") {
+        return is_uniform(2, is_int_like);
+    } else if (name == "fma") {
+        return is_uniform(3, [&] (const artic::Type* type) {
+            return is_var(type) || is_float_type(elem_of(type));
+        });
+    } else if (name == "min" || name == "max") {
+        return is_uniform(2, [&] (const artic::Type* type) {
+            return is_var(type) || is_int_or_float_type(elem_of(type));
+        });
+    } else if (name == "mul_wide") {
+        // The result must be a wider integer type with the same signedness as the operands
+        if (args.size() != 2 || args[0] != args[1] || !is_int_like(args[0]) || !is_int_like(fn_type->codom))
+            return false;
+        if (is_var(args[0]) || is_var(fn_type->codom))
+            return true;
+        return
+            !is_simd_type(args[0]) && !is_simd_type(fn_type->codom) &&
+            int_bits(fn_type->codom) > int_bits(args[0]) &&
+            is_signed_int_type(fn_type->codom) == is_signed_int_type(args[0]);
+    }
+
+    // Built-in functions operating on memory take a pointer (in any address space) as their first argument.
+    // Memory orders for atomic operations are given as LLVM orderings.
+    if (name == "prefetch") {
+        return ptr_type && args.size() == 3 &&
+            is_int_type(args[1]) && is_int_type(args[2]) && is_unit_type(fn_type->codom);
+    } else if (name == "assume_aligned") {
+        return ptr_type && args.size() == 2 && is_int_type(args[1]) && fn_type->codom == ptr_type;
+    } else if (name == "load_nt") {
+        return ptr_type && args.size() == 1 && fn_type->codom == ptr_type->pointee;
+    } else if (name == "store_nt") {
+        return ptr_type && ptr_type->is_mut && args.size() == 2 &&
+            args[1] == ptr_type->pointee && is_unit_type(fn_type->codom);
+    } else if (name == "fence") {
+        return args.size() == 1 && is_int_type(args[0]) && is_unit_type(fn_type->codom);
+    } else if (name.compare(0, 7, "atomic_") == 0) {
+        // Atomic operations work on integers, and take memory orders as integers. Like LLVM,
+        // only loads, stores, exchanges and compare-and-swap operations also work on pointers.
+        bool allows_ptrs = name == "atomic_load" || name == "atomic_store" || name == "atomic_xchg" || name == "atomic_cas";
+        if (!ptr_type || (!is_int_type(ptr_type->pointee) &&
+            !(allows_ptrs && ptr_type->pointee->isa<artic::PtrType>()) && !ptr_type->pointee->isa<artic::TypeVar>()))
+            return false;
+        auto value_type = ptr_type->pointee;
+        if (name == "atomic_load")
+            return args.size() == 2 && is_int_type(args[1]) && fn_type->codom == value_type;
+        if (!ptr_type->is_mut)
+            return false;
+        if (name == "atomic_store") {
+            return args.size() == 3 && args[1] == value_type &&
+                is_int_type(args[2]) && is_unit_type(fn_type->codom);
+        } else if (name == "atomic_cas") {
+            auto ret_type = fn_type->codom->isa<artic::TupleType>();
+            return args.size() == 5 && args[1] == value_type && args[2] == value_type &&
+                is_int_type(args[3]) && is_int_type(args[4]) &&
+                ret_type && ret_type->args.size() == 2 &&
+                ret_type->args[0] == value_type && is_bool_type(ret_type->args[1]);
+        }
+        return args.size() == 3 && args[1] == value_type && is_int_type(args[2]) && fn_type->codom == value_type;
+    }
+    return true;
+}
+
+void TypeChecker::check_builtin_args(const ast::Path& path, const ast::Expr& arg) {
+    auto fn_decl = path.symbol && !path.symbol->decls.empty() ? path.symbol->decls.front()->isa<ast::FnDecl>() : nullptr;
+    if (!fn_decl)
+        return;
+    auto name = builtin_name(*fn_decl);
+    auto tuple_expr = arg.isa<ast::TupleExpr>();
+    for (auto& [index, values] : constant_builtin_args(name)) {
+        if (tuple_expr ? index >= tuple_expr->args.size() : index > 0)
+            continue;
+        auto& arg_expr = tuple_expr ? *tuple_expr->args[index] : arg;
+        auto value = int_literal(arg_expr);
+        if (!value)
+            error(arg_expr.loc, "argument {} of built-in function '{}' must be an integer literal", index + 1, name);
+        else if (std::find(values.begin(), values.end(), *value) == values.end())
+            error(arg_expr.loc, "invalid value '{}' for argument {} of built-in function '{}'", *value, index + 1, name);
+    }
+}
+
 namespace ast {
 
 const artic::Type* Node::check(TypeChecker& checker, const artic::Type* expected) {
@@ -475,6 +754,8 @@ const artic::Type* Path::infer(TypeChecker& checker, bool value_expected, Ptr<Ex
     if (!symbol || symbol->decls.empty())
         return checker.type_table.type_error();
     auto type = checker.infer(*symbol->decls.front());
+    if (auto ptrn_decl = symbol->decls.front()->isa<PtrnDecl>(); ptrn_decl && ptrn_decl->is_mut)
+        checker.use_var(*ptrn_decl);
     bool is_type = elems.size() == 1 &&
         (symbol->decls.front()->isa<TypeDecl>() ||
          symbol->decls.front()->isa<TypeParam>() ||
@@ -526,6 +807,26 @@ const artic::Type* Path::infer(TypeChecker& checker, bool value_expected, Ptr<Ex
         }
         elem.type = type;
 
+        // Built-in functions with constant arguments can only be checked when they are called directly
+        if (!arg && i == n - 1) {
+            if (auto fn_decl = symbol->decls.front()->isa<FnDecl>()) {
+                if (auto name = builtin_name(*fn_decl); !name.empty() && !constant_builtin_args(name).empty()) {
+                    checker.error(elem.loc, "built-in function '{}' must be called directly", name);
+                    return checker.type_table.type_error();
+                }
+            }
+        }
+
+        // Instances of built-in functions can only be checked once their type arguments are known
+        if (!elem.inferred_args.empty()) {
+            if (auto fn_decl = symbol->decls.front()->isa<FnDecl>()) {
+                if (auto name = builtin_name(*fn_decl); !name.empty() && !is_valid_builtin(name, type)) {
+                    checker.error(elem.loc, "invalid instance of built-in function '{}' with type '{}'", name, *type);
+                    return checker.type_table.type_error();
+                }
+            }
+        }
+
         // Perform a lookup inside the current object if the path is not finished
         if (i != n - 1) {
             if (auto [type_app, enum_type] = match_app<EnumType>(type); enum_type) {
@@ -565,9 +866,10 @@ void NamedAttr::check(TypeChecker& checker, const ast::Node* node) {
         if (auto fn_decl = node->isa<FnDecl>()) {
             if (name == "export") {
                 auto fn_type = fn_decl->type->isa<artic::FnType>();
-                if (!fn_type)
+                if (!fn_type && !fn_decl->attrs->find("instantiate")) {
                     checker.error(fn_decl->loc, "polymorphic functions cannot be exported");
-                else if (fn_decl->type->order() > 1)
+                    checker.note("use 'instantiate' attributes to export some of its instances");
+                } else if (fn_type && fn_decl->type->order() > 1)
                     checker.error(fn_decl->loc, "higher-order functions cannot be exported");
                 else
                     checker.check_attrs(*this, { { "name", AttrType::String } });
@@ -579,9 +881,19 @@ void NamedAttr::check(TypeChecker& checker, const ast::Node* node) {
                     if (auto cc_attr = find("cc")) {
                         auto& cc = cc_attr->as<LiteralAttr>()->lit.as_string();
                         if (cc == "builtin") {
-                            if (name != "alignof" && name != "bitcast" && name != "insert" &&
-                                name != "select"  && name != "sizeof"  && name != "undef")
+                            static constexpr std::string_view builtins[] = {
+                                "alignof", "bitcast", "insert", "select", "sizeof", "undef",
+                                "popcount", "clz", "ctz", "bswap", "rotl", "rotr", "fma",
+                                "min", "max", "add_sat", "sub_sat", "mul_wide",
+                                "prefetch", "assume_aligned", "load_nt", "store_nt",
+                                "atomic_load", "atomic_store", "atomic_xchg", "atomic_cas",
+                                "atomic_add", "atomic_sub", "atomic_and", "atomic_or", "atomic_xor",
+                                "atomic_min", "atomic_max", "fence"
+                            };
+                            if (std::find(std::begin(builtins), std::end(builtins), name) == std::end(builtins))
                                 checker.error(fn_decl->loc, "unsupported built-in function");
+                            else if (!is_valid_builtin(name, fn_decl->type))
+                                checker.error(fn_decl->loc, "invalid signature for built-in function '{}'", name);
                         } else if (cc != "C" && cc != "device" && cc != "thorin")
                             checker.error(cc_attr->loc, "invalid calling convention '{}'", cc);
                     }
@@ -591,6 +903,93 @@ void NamedAttr::check(TypeChecker& checker, const ast::Node* node) {
             }
         } else
             checker.error(loc, "attribute '{}' is only valid for function declarations", name);
+    } else if (
+        name == "inline" || name == "noinline" || name == "cold" ||
+        name == "hot"    || name == "pure"     || name == "readonly") {
+        if (auto fn_decl = node->isa<FnDecl>()) {
+            // Only report conflicts on the second attribute of each pair
+            static const std::pair<std::string_view, std::string_view> conflicts[] = {
+                { "inline", "noinline" }, { "cold", "hot" }, { "pure", "readonly" }
+            };
+            for (auto& [first, second] : conflicts) {
+                if (name == second && fn_decl->attrs->find(first))
+                    checker.error(loc, "attributes '{}' and '{}' cannot be used together", first, second);
+            }
+            checker.check_attrs(*this, {});
+        } else
+            checker.error(loc, "attribute '{}' is only valid for function declarations", name);
+    } else if (name == "soa") {
+        if (node->isa<StructDecl>())
+            checker.check_attrs(*this, {});
+        else
+            checker.error(loc, "attribute '{}' is only valid for structures", name);
+    } else if (name == "packed") {
+        if (node->isa<StructDecl>()) {
+            checker.error(loc, "packed structures are not supported");
+            checker.note("structure fields always use their natural alignment, which can only be increased with 'align'");
+        } else
+            checker.error(loc, "attribute '{}' is only valid for structures", name);
+    } else if (name == "unroll" || name == "no_unroll" || name == "vectorize") {
+        if (node->isa<WhileExpr>() || node->isa<ForExpr>()) {
+            if (name == "no_unroll" && node->attrs->find("unroll"))
+                checker.error(loc, "attributes '{}' and '{}' cannot be used together", "unroll", "no_unroll");
+            checker.check_attrs(*this, {});
+        } else
+            checker.error(loc, "attribute '{}' is only valid for loops", name);
+    } else if (name == "fast_math") {
+        // Fast-math flags, as in `#[fast_math(nnan, reassoc)]`, or all of them with `#[fast_math]`
+        if (node->isa<FnDecl>() || node->isa<BlockExpr>()) {
+            std::vector<AttrType> attr_types;
+            for (auto flag : LLVMHints::fast_math_flags)
+                attr_types.push_back(AttrType { flag, AttrType::Other });
+            if (checker.check_attrs(*this, attr_types)) {
+                for (auto& arg : args) {
+                    if (!arg->isa<NamedAttr>() || !arg->as<NamedAttr>()->args.empty())
+                        checker.error(arg->loc, "malformed '{}' attribute", arg->name);
+                }
+            }
+        } else
+            checker.error(loc, "attribute '{}' is only valid for function declarations and blocks", name);
+    } else if (name == "instantiate") {
+        auto fn_decl = node->isa<FnDecl>();
+        if (!fn_decl || !fn_decl->type_params)
+            checker.error(loc, "attribute 'instantiate' is only valid for polymorphic function declarations");
+        else if (!fn_decl->attrs->find("export"))
+            checker.error(loc, "attribute 'instantiate' is only valid for exported functions");
+        else {
+            auto& params = fn_decl->type_params->params;
+            std::vector<AttrType> attr_types { { "name", AttrType::String } };
+            for (auto& param : params)
+                attr_types.push_back(AttrType { param->id.name, AttrType::Other });
+            if (!checker.check_attrs(*this, attr_types))
+                return;
+
+            // Type arguments are either types or paths to types
+            std::vector<const artic::Type*> type_args(params.size(), nullptr);
+            for (auto& arg : args) {
+                auto it = std::find_if(params.begin(), params.end(), [&] (auto& param) {
+                    return param->id.name == arg->name;
+                });
+                if (it == params.end())
+                    continue;
+                if (auto type_attr = arg->isa<TypeAttr>())
+                    type_args[it - params.begin()] = checker.infer(*type_attr->type);
+                else if (auto path_attr = arg->isa<PathAttr>())
+                    type_args[it - params.begin()] = path_attr->path.type = path_attr->path.infer(checker, false, nullptr);
+                else {
+                    checker.error(arg->loc, "malformed '{}' attribute", arg->name);
+                    return;
+                }
+            }
+            for (size_t i = 0, n = params.size(); i < n; ++i) {
+                if (!type_args[i]) {
+                    checker.error(loc, "missing type argument for type parameter '{}'", params[i]->id.name);
+                    return;
+                }
+            }
+            if (fn_decl->type->as<artic::ForallType>()->instantiate(type_args)->order() > 1)
+                checker.error(loc, "higher-order functions cannot be exported");
+        }
     } else
         checker.invalid_attr(loc, name);
 }
@@ -599,10 +998,27 @@ void PathAttr::check(TypeChecker& checker, const ast::Node*) {
     checker.invalid_attr(loc, name);
 }
 
-void LiteralAttr::check(TypeChecker& checker, const ast::Node*) {
+void TypeAttr::check(TypeChecker& checker, const ast::Node*) {
     checker.invalid_attr(loc, name);
 }
 
+void LiteralAttr::check(TypeChecker& checker, const ast::Node* node) {
+    // Loop hints with a count, as in `#[unroll = 4]`
+    if (name == "unroll" || name == "vectorize" || name == "interleave") {
+        if (!node->isa<WhileExpr>() && !node->isa<ForExpr>())
+            checker.error(loc, "attribute '{}' is only valid for loops", name);
+        else if (!lit.is_integer() || lit.as_integer() == 0)
+            checker.error(loc, "malformed '{}' attribute", name);
+    } else if (name == "align") {
+        // Minimum alignment of a structure or structure field, as in `#[align = 64]`
+        if (!node->isa<StructDecl>() && !node->isa<FieldDecl>())
+            checker.error(loc, "attribute '{}' is only valid for structures and structure fields", name);
+        else if (!lit.is_integer() || lit.as_integer() == 0 || (lit.as_integer() & (lit.as_integer() - 1)) != 0)
+            checker.error(loc, "alignment must be a power of two");
+    } else
+        checker.invalid_attr(loc, name);
+}
+
 void AttrList::check(TypeChecker& checker, const ast::Node* parent) {
     for (auto& arg : args)
         arg->check(checker, parent);
@@ -645,7 +1061,7 @@ const artic::Type* PtrType::infer(TypeChecker& checker) {
         pointee_type = checker.type_table.unsized_array_type(checker.infer(*unsized_array_type->elem));
     else
         pointee_type = checker.infer(*pointee);
-    return checker.type_table.ptr_type(pointee_type, is_mut, addr_space);
+    return checker.type_table.ptr_type(pointee_type, is_mut, addr_space, is_noalias);
 }
 
 const artic::Type* TypeApp::infer(TypeChecker& checker) {
@@ -757,6 +1173,7 @@ const artic::Type* RepeatArrayExpr::check(TypeChecker& checker, const artic::Typ
 }
 
 const artic::Type* FnExpr::infer(TypeChecker& checker) {
+    checker.enter_region(this);
     auto param_type = checker.infer(*param);
     if (filter)
         checker.check(*filter, checker.type_table.bool_type());
@@ -767,6 +1184,7 @@ const artic::Type* FnExpr::infer(TypeChecker& checker) {
         else
             body_type = checker.deref(body);
     }
+    checker.exit_region();
     return body_type
         ? checker.type_table.fn_type(param_type, body_type)
         : checker.cannot_infer(loc, "function");
@@ -778,11 +1196,13 @@ const artic::Type* FnExpr::check(TypeChecker& checker, const artic::Type* expect
     // Set the type of the expression before entering the body,
     // in case `return` appears in it.
     type = expected;
+    checker.enter_region(this);
     auto codom = expected->as<artic::FnType>()->codom;
     auto param_type = checker.check(*param, expected->as<artic::FnType>()->dom);
     auto body_type  = checker.coerce(body, ret_type ? checker.check(*ret_type, codom) : codom);
     if (filter)
         checker.check(*filter, checker.type_table.bool_type());
+    checker.exit_region();
     return checker.type_table.fn_type(param_type, body_type);
 }
 
@@ -820,12 +1240,23 @@ const artic::Type* CallExpr::infer(TypeChecker& checker) {
             path_expr->path.infer(checker, true, &arg);
     }
 
+    // Direct calls to `break` and `continue` are regions, since
+    // their argument is evaluated before leaving the loop
+    bool is_jump = callee->isa<BreakExpr>() || callee->isa<ContinueExpr>();
+    if (is_jump)
+        checker.enter_region(this);
     auto [ref_type, callee_type] = remove_ref(checker.infer(*callee));
     if (auto fn_type = callee_type->isa<artic::FnType>()) {
         checker.coerce(callee, fn_type);
         checker.coerce(arg, fn_type->dom);
+        if (auto path_expr = callee->isa<ast::PathExpr>())
+            checker.check_builtin_args(path_expr->path, *arg);
+        if (is_jump)
+            checker.exit_region();
         return fn_type->codom;
     } else {
+        if (is_jump)
+            checker.exit_region();
         // Accept pointers to arrays
         auto ptr_type = callee_type->isa<artic::PtrType>();
         if (ptr_type) {
@@ -873,20 +1304,28 @@ const artic::Type* ProjExpr::infer(TypeChecker& checker) {
 }
 
 const artic::Type* IfExpr::infer(TypeChecker& checker) {
+    checker.enter_region(this);
     checker.coerce(cond, checker.type_table.bool_type());
-    if (if_false)
-        return checker.join(if_false, if_true);
-    return checker.coerce(if_true, checker.type_table.unit_type());
+    auto type = if_false
+        ? checker.join(if_false, if_true)
+        : checker.coerce(if_true, checker.type_table.unit_type());
+    checker.exit_region();
+    return type;
 }
 
 const artic::Type* IfExpr::check(TypeChecker& checker, const artic::Type* expected) {
+    checker.enter_region(this);
     checker.coerce(cond, checker.type_table.bool_type());
+    const artic::Type* type = nullptr;
     if (if_false) {
         checker.coerce(if_true, expected);
-        return checker.coerce(if_false, expected);
+        type = checker.coerce(if_false, expected);
+    } else {
+        checker.coerce(if_true, checker.type_table.unit_type());
+        type = checker.coerce(if_true, expected);
     }
-    checker.coerce(if_true, checker.type_table.unit_type());
-    return checker.coerce(if_true, expected);
+    checker.exit_region();
+    return type;
 }
 
 const artic::Type* MatchExpr::infer(TypeChecker& checker) {
@@ -894,19 +1333,24 @@ const artic::Type* MatchExpr::infer(TypeChecker& checker) {
 }
 
 const artic::Type* MatchExpr::check(TypeChecker& checker, const artic::Type* expected) {
+    checker.enter_region(this);
     auto arg_type = checker.deref(arg);
     const artic::Type* type = expected;
     for (auto& case_ : cases) {
         checker.check(*case_->ptrn, arg_type);
         type = type ? checker.coerce(case_->expr, type) : checker.deref(case_->expr);
     }
+    checker.exit_region();
     return type ? type : checker.cannot_infer(loc, "match expression");
 }
 
 const artic::Type* WhileExpr::infer(TypeChecker& checker) {
+    checker.enter_region(this);
     checker.coerce(cond, checker.type_table.bool_type());
     // Using infer mode here would cause the type system to allow code such as: while true { break }
-    return checker.coerce(body, checker.type_table.unit_type());
+    auto type = checker.coerce(body, checker.type_table.unit_type());
+    checker.exit_region();
+    return type;
 }
 
 const artic::Type* ForExpr::infer(TypeChecker& checker) {
@@ -914,6 +1358,7 @@ const artic::Type* ForExpr::infer(TypeChecker& checker) {
 }
 
 const artic::Type* BreakExpr::infer(TypeChecker& checker) {
+    checker.register_jump(*loop, *this);
     const artic::Type* domain = nullptr;
     if (loop->isa<WhileExpr>())
         domain = checker.type_table.unit_type();
@@ -934,6 +1379,7 @@ const artic::Type* BreakExpr::infer(TypeChecker& checker) {
 }
 
 const artic::Type* ContinueExpr::infer(TypeChecker& checker) {
+    checker.register_jump(*loop, *this);
     const artic::Type* domain = nullptr;
     if (loop->isa<WhileExpr>())
         domain = checker.type_table.unit_type();
@@ -973,6 +1419,18 @@ const artic::Type* ReturnExpr::infer(TypeChecker& checker) {
     return checker.type_table.type_error();
 }
 
+/// Returns true if the expression is an element of a sized array of `#[soa]` structures.
+static bool is_soa_elem(const Expr& expr) {
+    auto call_expr = expr.isa<CallExpr>();
+    if (!call_expr || !call_expr->callee->type)
+        return false;
+    auto callee_type = remove_ref(call_expr->callee->type).second;
+    if (auto ptr_type = callee_type->isa<artic::PtrType>())
+        callee_type = ptr_type->pointee;
+    auto array_type = callee_type->isa<artic::SizedArrayType>();
+    return array_type && is_soa_type(array_type->elem);
+}
+
 const artic::Type* UnaryExpr::infer(TypeChecker& checker) {
     auto [ref_type, arg_type] = remove_ref(checker.infer(*arg));
     if ((!ref_type || !ref_type->is_mut) && (tag == AddrOfMut || is_inc() || is_dec()))
@@ -987,6 +1445,11 @@ const artic::Type* UnaryExpr::infer(TypeChecker& checker) {
         // Return the original type, unchanged
         return arg->type;
     }
+    if ((tag == AddrOf || tag == AddrOfMut) && ref_type && is_soa_elem(*arg)) {
+        checker.error(loc, "cannot take the address of an element of an array of '{}' structures", "soa");
+        checker.note("only the fields of such elements have an address");
+        return checker.type_table.type_error();
+    }
     if (tag == AddrOf)
         return checker.type_table.ptr_type(arg_type, false, ref_type ? ref_type->addr_space : 0);
     if (tag == AddrOfMut) {
@@ -1020,6 +1483,7 @@ const artic::Type* UnaryExpr::infer(TypeChecker& checker) {
         case PreInc:
         case PreDec:
             arg->write_to();
+            checker.write_var(*arg);
             if (!is_int_type(prim_type))
                 return checker.type_expected(arg->loc, arg_type, "integer");
             break;
@@ -1053,7 +1517,10 @@ const artic::Type* BinaryExpr::infer(TypeChecker& checker) {
     const artic::Type* right_type  = nullptr;
     if (is_logic()) {
         left_type  = checker.coerce(left, checker.type_table.bool_type());
+        // The right-hand side is only evaluated conditionally
+        checker.enter_region(this);
         right_type = checker.coerce(right, checker.type_table.bool_type());
+        checker.exit_region();
     } else if (!has_eq() && left->isa<LiteralExpr>()) {
         // Expressions like `1 + x` should be handled by inferring the right-hand side first
         right_type = checker.deref(right);
@@ -1107,6 +1574,7 @@ const artic::Type* BinaryExpr::infer(TypeChecker& checker) {
     }
     if (has_eq()) {
         left->write_to();
+        checker.write_var(*left);
         if (!left_ref || !left_ref->is_mut)
             return checker.mutable_expected(left->loc);
         return checker.type_table.unit_type();
@@ -1218,7 +1686,9 @@ const artic::Type* TypeParam::infer(TypeChecker& checker) {
     return checker.type_table.type_var(*this);
 }
 
-const artic::Type* PtrnDecl::check(TypeChecker&, const artic::Type* expected) {
+const artic::Type* PtrnDecl::check(TypeChecker& checker, const artic::Type* expected) {
+    if (is_mut)
+        checker.decl_var(*this);
     return expected;
 }
 
@@ -1258,6 +1728,7 @@ const artic::Type* FnDecl::infer(TypeChecker& checker) {
     if (!checker.enter_decl(this))
         return checker.type_table.type_error();
 
+    checker.enter_region(fn.get());
     const artic::Type* fn_type = nullptr;
     if (fn->ret_type) {
         fn_type = checker.type_table.fn_type(checker.infer(*fn->param), checker.infer(*fn->ret_type));
@@ -1274,6 +1745,7 @@ const artic::Type* FnDecl::infer(TypeChecker& checker) {
         forall->as<ForallType>()->body = fn_type;
     if (fn->ret_type && fn->body)
         checker.check(*fn->body, fn_type->as<artic::FnType>()->codom);
+    checker.exit_region();
     checker.exit_decl(this);
     return type;
 }
@@ -1,11 +1,19 @@
 #include "artic/emit.h"
+#include "artic/check.h"
 #include "artic/types.h"
 #include "artic/ast.h"
 #include "artic/print.h"
 
+#include <sstream>
+#include <algorithm>
+#include <unordered_set>
+#include <functional>
+#include <cctype>
+
 #include <thorin/def.h>
 #include <thorin/type.h>
 #include <thorin/world.h>
+#include <thorin/analyses/scope.h>
 
 namespace artic {
 
@@ -28,6 +36,378 @@ static thorin::Debug debug_info(const ast::Node& node, const std::string& name =
     return thorin::Debug { location(node.loc), name };
 }
 
+/// Returns the fast-math flags given with `#[fast_math]` (or `#[fast_math(nnan, reassoc)]`),
+/// each followed by a dot, or an empty string.
+static std::string fast_math_flags(const ast::AttrList* attrs) {
+    auto fast_math_attr = attrs ? attrs->find("fast_math") : nullptr;
+    if (!fast_math_attr)
+        return std::string();
+    std::string flags;
+    for (auto& arg : fast_math_attr->as<ast::NamedAttr>()->args)
+        flags += arg->name + ".";
+    return fast_math_attr->as<ast::NamedAttr>()->args.empty() ? "fast." : flags;
+}
+
+/// Returns the suffix used by overloaded LLVM intrinsics for the given type (e.g. `i32` or `v4f32`).
+static std::string intrinsic_suffix(const Type* type) {
+    if (auto array_type = type->isa<SizedArrayType>(); array_type && array_type->is_simd)
+        return "v" + std::to_string(array_type->size) + intrinsic_suffix(array_type->elem);
+    switch (type->as<PrimType>()->tag) {
+        case ast::PrimType::Bool: return "i1";
+        case ast::PrimType::I8:
+        case ast::PrimType::U8:   return "i8";
+        case ast::PrimType::I16:
+        case ast::PrimType::U16:  return "i16";
+        case ast::PrimType::I32:
+        case ast::PrimType::U32:  return "i32";
+        case ast::PrimType::I64:
+        case ast::PrimType::U64:  return "i64";
+        case ast::PrimType::F16:  return "f16";
+        case ast::PrimType::F32:  return "f32";
+        case ast::PrimType::F64:  return "f64";
+        default:
+            assert(false);
+            return "";
+    }
+}
+
+/// Returns the name of the LLVM floating-point operation performed by the given binary operator, or null.
+static const char* float_op(ast::BinaryExpr::Tag tag) {
+    switch (tag) {
+        case ast::BinaryExpr::Add:   return "fadd";
+        case ast::BinaryExpr::Sub:   return "fsub";
+        case ast::BinaryExpr::Mul:   return "fmul";
+        case ast::BinaryExpr::Div:   return "fdiv";
+        case ast::BinaryExpr::Rem:   return "frem";
+        case ast::BinaryExpr::CmpEq: return "fcmp_oeq";
+        case ast::BinaryExpr::CmpNE: return "fcmp_une";
+        case ast::BinaryExpr::CmpGT: return "fcmp_ogt";
+        case ast::BinaryExpr::CmpLT: return "fcmp_olt";
+        case ast::BinaryExpr::CmpGE: return "fcmp_oge";
+        case ast::BinaryExpr::CmpLE: return "fcmp_ole";
+        default:                     return nullptr;
+    }
+}
+
+/// Emits a floating-point operation with the fast-math flags in effect, as a call to a placeholder
+/// function that the LLVM hints replace by the operation with its flags (see `LLVMHints::apply`).
+/// Thorin operations are hash-consed regardless of their names, so that a regular operation would
+/// be merged with the same one outside of `#[fast_math]`. Returns null when no flags are in effect.
+static const thorin::Def* fast_math_op(
+    Emitter& emitter, const ast::Node& node, const std::string& op,
+    const Type* type, const thorin::Type* ret_type, std::vector<const thorin::Def*>&& args)
+{
+    if (auto ref_type = type->isa<RefType>())
+        type = ref_type->pointee;
+    type = type->replace(emitter.type_vars);
+    auto elem_type = is_simd_type(type) ? type->as<SizedArrayType>()->elem : type;
+    if (emitter.state.fast_math.empty() || !emitter.state.cont || !is_float_type(elem_type))
+        return nullptr;
+
+    auto& world = emitter.world;
+    auto next = emitter.basic_block_with_mem(ret_type, debug_info(node, "fast_math"));
+    args.insert(args.begin(), emitter.state.mem);
+    args.push_back(next);
+    thorin::Array<const thorin::Type*> types(args.size());
+    for (size_t i = 0, n = args.size(); i < n; ++i)
+        types[i] = args[i]->type();
+    auto name = LLVMHints::fast_math_prefix + op + "." + emitter.state.fast_math + intrinsic_suffix(type);
+    auto placeholder = world.continuation(world.fn_type(types), thorin::Debug(name));
+    placeholder->cc() = thorin::CC::C;
+    emitter.host_only_fns.emplace(name, std::pair("floating-point operation with fast-math flags", node.loc));
+    emitter.state.cont->jump(placeholder, args, debug_info(node));
+    emitter.enter(next);
+    return next->param(1);
+}
+
+/// Returns the alignment given with `#[align = N]` on a declaration, or zero.
+static size_t decl_align(const ast::NamedDecl& decl) {
+    if (auto align_attr = decl.attrs ? decl.attrs->find("align") : nullptr)
+        return align_attr->as<ast::LiteralAttr>()->lit.as_integer();
+    return 0;
+}
+
+/// Returns the index of a structure field in the converted Thorin structure,
+/// where aligned fields are preceded by a marker (see `StructType::convert`).
+static size_t field_index(const ast::StructDecl& decl, size_t index) {
+    size_t markers = 0;
+    for (size_t i = 0; i <= index; ++i)
+        markers += decl_align(*decl.fields[i]) != 0;
+    return index + markers;
+}
+
+/// Representation of an enumeration in Thorin IR.
+enum class EnumLayout {
+    Tagged,      ///< Structure containing the tag and a variant with the payload.
+    Tag,         ///< Tag only, when no option has a payload.
+    NullablePtr  ///< Payload only, for pointers, where the other option is the null pointer.
+};
+
+/// Returns true if the given type contains the target type, including through the options of
+/// enumerations. Unlike structures, those are not always converted to named Thorin types,
+/// which means that enumerations that refer to each other could be converted forever.
+static bool reaches_type(
+    const artic::Type* type,
+    const artic::Type* target,
+    std::unordered_set<const artic::Type*>& visited)
+{
+    if (type == target)
+        return true;
+    if (!visited.insert(type).second)
+        return false;
+    if (auto tuple_type = type->isa<artic::TupleType>()) {
+        return std::any_of(tuple_type->args.begin(), tuple_type->args.end(),
+            [&] (auto arg) { return reaches_type(arg, target, visited); });
+    } else if (auto array_type = type->isa<artic::ArrayType>())
+        return reaches_type(array_type->elem, target, visited);
+    else if (auto addr_type = type->isa<artic::AddrType>())
+        return reaches_type(addr_type->pointee, target, visited);
+    else if (auto fn_type = type->isa<artic::FnType>())
+        return reaches_type(fn_type->dom, target, visited) || reaches_type(fn_type->codom, target, visited);
+    else if (auto [type_app, enum_type] = match_app<artic::EnumType>(type); enum_type) {
+        for (size_t i = 0, n = enum_type->member_count(); i < n; ++i) {
+            if (reaches_type(type_app ? type_app->member_type(i) : enum_type->member_type(i), target, visited))
+                return true;
+        }
+    }
+    return false;
+}
+
+static EnumLayout enum_layout(Emitter& emitter, const artic::Type* type) {
+    auto mono_type = type->replace(emitter.type_vars);
+    auto [type_app, enum_type] = match_app<artic::EnumType>(mono_type);
+    size_t unit_count = 0;
+    const artic::Type* payload_type = nullptr;
+    for (size_t i = 0, n = enum_type->member_count(); i < n; ++i) {
+        auto member_type = type_app ? type_app->member_type(i) : enum_type->member_type(i);
+        if (is_unit_type(member_type))
+            unit_count++;
+        else
+            payload_type = member_type;
+    }
+    if (unit_count == enum_type->member_count())
+        return EnumLayout::Tag;
+    // Recursive enumerations cannot be represented by a pointer to themselves,
+    // whether directly or through other enumerations (e.g. `enum A { N, P(&B) }`
+    // and `enum B { M, Q(&A) }`).
+    std::unordered_set<const artic::Type*> visited;
+    if (auto ptr_type = payload_type->isa<artic::PtrType>();
+        enum_type->member_count() == 2 && unit_count == 1 && ptr_type &&
+        !reaches_type(ptr_type->pointee, mono_type, visited))
+        return EnumLayout::NullablePtr;
+    return EnumLayout::Tagged;
+}
+
+/// Builds a value of an enumeration from the option index and its payload, if any.
+static const thorin::Def* make_enum(
+    Emitter& emitter,
+    const artic::Type* type,
+    size_t index,
+    const thorin::Def* payload,
+    thorin::Debug debug)
+{
+    auto enum_type = match_app<artic::EnumType>(type).second;
+    auto converted_type = type->convert(emitter);
+    switch (enum_layout(emitter, type)) {
+        case EnumLayout::Tag:
+            return emitter.ctor_index(enum_type, index);
+        case EnumLayout::NullablePtr:
+            return payload ? payload : emitter.world.cast(converted_type, emitter.world.literal_pu64(0, {}), debug);
+        default: {
+            auto variant_type = converted_type->op(1)->as<thorin::VariantType>();
+            return emitter.world.struct_agg(converted_type->as<thorin::StructType>(), {
+                emitter.ctor_index(enum_type, index),
+                emitter.world.variant(variant_type, payload ? payload : emitter.world.tuple({}))
+            }, debug);
+        }
+    }
+}
+
+/// Returns the tag of a value of an enumeration, as given by `Emitter::ctor_index()`.
+static const thorin::Def* enum_tag(Emitter& emitter, const artic::Type* type, const thorin::Def* value, thorin::Debug debug) {
+    auto [type_app, enum_type] = match_app<artic::EnumType>(type);
+    switch (enum_layout(emitter, type)) {
+        case EnumLayout::Tag:
+            return value;
+        case EnumLayout::NullablePtr: {
+            auto is_null = emitter.world.cmp_eq(
+                emitter.world.cast(emitter.world.type_pu64(), value, debug),
+                emitter.world.literal_pu64(0, {}), debug);
+            size_t null_index = is_unit_type(type_app ? type_app->member_type(0) : enum_type->member_type(0)) ? 0 : 1;
+            return emitter.world.select(is_null,
+                emitter.ctor_index(enum_type, null_index),
+                emitter.ctor_index(enum_type, 1 - null_index), debug);
+        }
+        default:
+            return emitter.world.extract(value, thorin::u32(0), debug);
+    }
+}
+
+/// Returns the payload of a value of an enumeration, for the option with the given type.
+static const thorin::Def* enum_payload(
+    Emitter& emitter,
+    const artic::Type* type,
+    const thorin::Def* value,
+    const artic::Type* member_type,
+    thorin::Debug debug)
+{
+    if (enum_layout(emitter, type) == EnumLayout::NullablePtr)
+        return value;
+    return emitter.world.cast(member_type->convert(emitter), emitter.world.extract(value, thorin::u32(1), debug), debug);
+}
+
+/// Builds a structure from the values of its fields, in declaration order.
+static const thorin::Def* make_struct(
+    Emitter& emitter,
+    const artic::Type* type,
+    const thorin::Array<const thorin::Def*>& fields,
+    thorin::Debug debug)
+{
+    auto [_, struct_type] = match_app<artic::StructType>(type);
+    auto converted_type = type->convert(emitter)->as<thorin::StructType>();
+    thorin::Array<const thorin::Def*> ops(converted_type->num_ops());
+    // Operands that are not fields are alignment markers, which have no value
+    for (size_t i = 0, n = ops.size(); i < n; ++i)
+        ops[i] = emitter.world.bottom(converted_type->op(i));
+    for (size_t i = 0, n = fields.size(); i < n; ++i)
+        ops[field_index(struct_type->decl, i)] = fields[i];
+    return emitter.world.struct_agg(converted_type, ops, debug);
+}
+
+/// Returns the (monomorphic) element type of the given array (or pointer or reference to it),
+/// if it is a sized array of `#[soa]` structures, or null otherwise.
+static const artic::Type* soa_elem_type(Emitter& emitter, const artic::Type* type) {
+    type = type->replace(emitter.type_vars);
+    if (auto ref_type = type->isa<artic::RefType>())
+        type = ref_type->pointee;
+    if (auto ptr_type = type->isa<artic::PtrType>())
+        type = ptr_type->pointee;
+    if (auto array_type = type->isa<artic::SizedArrayType>(); array_type && is_soa_type(array_type->elem))
+        return array_type->elem;
+    return nullptr;
+}
+
+/// Returns the given expression if it is a reference to an element of a sized array of
+/// `#[soa]` structures. Such elements do not have an address, only their fields do.
+static const ast::CallExpr* soa_elem_ref(Emitter& emitter, const ast::Expr& expr) {
+    auto call_expr = expr.isa<ast::CallExpr>();
+    return call_expr && expr.type->isa<artic::RefType>() && soa_elem_type(emitter, call_expr->callee->type)
+        ? call_expr : nullptr;
+}
+
+/// Returns true if the given cast converts a sized array of `#[soa]` structures (or a pointer to it)
+/// into a pointer to an unsized array. This mirrors `Emitter::down_cast`, which would reinterpret
+/// the structure of arrays as an array of structures.
+static bool is_soa_array_cast(Emitter& emitter, const artic::Type* from, const artic::Type* to) {
+    if (to == from || to->isa<artic::TopType>() || from->isa<artic::BottomType>())
+        return false;
+    else if (auto from_ref_type = from->isa<artic::RefType>(); from_ref_type && from_ref_type->pointee->subtype(to))
+        return is_soa_array_cast(emitter, from_ref_type->pointee, to);
+    else if (auto to_ptr_type = to->isa<artic::PtrType>()) {
+        if (!to_ptr_type->is_mut && from->subtype(to_ptr_type->pointee))
+            return is_soa_array_cast(emitter, from, to_ptr_type->pointee);
+        auto from_ptr_type = from->isa<artic::PtrType>();
+        if (from_ptr_type &&
+            (from_ptr_type->is_mut || !to_ptr_type->is_mut) &&
+            from_ptr_type->pointee->subtype(to_ptr_type->pointee))
+            return is_soa_array_cast(emitter, from_ptr_type->pointee, to_ptr_type->pointee);
+        // The remaining cases convert sized arrays into unsized ones
+        return soa_elem_type(emitter, from) != nullptr;
+    } else if (auto from_tuple_type = from->isa<artic::TupleType>()) {
+        for (size_t i = 0, n = from_tuple_type->args.size(); i < n; ++i) {
+            if (is_soa_array_cast(emitter, from_tuple_type->args[i], to->as<artic::TupleType>()->args[i]))
+                return true;
+        }
+    } else if (auto from_fn_type = from->isa<artic::FnType>()) {
+        return
+            is_soa_array_cast(emitter, to->as<artic::FnType>()->dom, from_fn_type->dom) ||
+            is_soa_array_cast(emitter, from_fn_type->codom, to->as<artic::FnType>()->codom);
+    }
+    return false;
+}
+
+/// Emits pointers to the fields of an element of a sized array of
+/// `#[soa]` structures, which stores one array per field.
+static std::vector<const thorin::Def*> soa_field_ptrs(Emitter& emitter, const ast::CallExpr& call_expr) {
+    auto [_, struct_type] = match_app<artic::StructType>(soa_elem_type(emitter, call_expr.callee->type));
+    auto array = emitter.emit(*call_expr.callee);
+    auto index = emitter.emit(*call_expr.arg);
+    std::vector<const thorin::Def*> ptrs(struct_type->member_count());
+    for (size_t i = 0, n = ptrs.size(); i < n; ++i) {
+        auto field_array = emitter.world.lea(array, emitter.world.literal_pu64(i, {}), debug_info(call_expr));
+        ptrs[i] = emitter.world.lea(field_array, index, debug_info(call_expr));
+    }
+    return ptrs;
+}
+
+/// Emits a sized array of `#[soa]` structures from its elements.
+static const thorin::Def* soa_array(
+    Emitter& emitter,
+    const artic::Type* type,
+    const thorin::Array<const thorin::Def*>& elems,
+    thorin::Debug debug)
+{
+    auto [_, struct_type] = match_app<artic::StructType>(soa_elem_type(emitter, type));
+    thorin::Array<const thorin::Def*> field_arrays(struct_type->member_count());
+    for (size_t i = 0, n = field_arrays.size(); i < n; ++i) {
+        thorin::Array<const thorin::Def*> ops(elems.size());
+        for (size_t j = 0, m = elems.size(); j < m; ++j)
+            ops[j] = emitter.world.extract(elems[j], field_index(struct_type->decl, i), debug);
+        field_arrays[i] = emitter.world.definite_array(ops, debug);
+    }
+    return emitter.world.struct_agg(type->convert(emitter)->as<thorin::StructType>(), field_arrays, debug);
+}
+
+/// Returns an estimate of the size in bytes of a value of the given (monomorphic) type.
+static size_t value_size(const artic::Type* type) {
+    if (auto prim_type = type->isa<artic::PrimType>()) {
+        switch (prim_type->tag) {
+            case ast::PrimType::Bool:
+            case ast::PrimType::I8:
+            case ast::PrimType::U8:
+                return 1;
+            case ast::PrimType::I16:
+            case ast::PrimType::U16:
+            case ast::PrimType::F16:
+                return 2;
+            case ast::PrimType::I32:
+            case ast::PrimType::U32:
+            case ast::PrimType::F32:
+                return 4;
+            default:
+                return 8;
+        }
+    } else if (auto tuple_type = type->isa<artic::TupleType>()) {
+        size_t size = 0;
+        for (auto arg : tuple_type->args)
+            size += value_size(arg);
+        return size;
+    } else if (auto array_type = type->isa<artic::SizedArrayType>()) {
+        return array_type->size * value_size(array_type->elem);
+    } else if (auto [type_app, complex_type] = match_app<artic::ComplexType>(type); complex_type) {
+        // Enumerations store the largest payload along with the tag
+        bool is_enum = complex_type->isa<artic::EnumType>();
+        size_t size = 0;
+        for (size_t i = 0, n = complex_type->member_count(); i < n; ++i) {
+            auto member_size = value_size(type_app ? type_app->member_type(i) : complex_type->member_type(i));
+            size = is_enum ? std::max(size, member_size) : size + member_size;
+        }
+        return is_enum ? size + 4 : size;
+    }
+    return 8;
+}
+
+/// Returns true if values of the given type are passed to functions by reference,
+/// which is the case for structures, tuples, and arrays above the emitter threshold.
+static bool is_passed_by_ref(Emitter& emitter, const artic::Type* type) {
+    auto array_type = type->isa<artic::SizedArrayType>();
+    bool is_aggregate =
+        type->isa<artic::TupleType>() ||
+        (array_type && !array_type->is_simd) ||
+        match_app<artic::StructType>(type).second;
+    return is_aggregate && emitter.by_ref_threshold != 0 && value_size(type) >= emitter.by_ref_threshold;
+}
+
 /// Pattern matching compiler inspired from
 /// "Compiling Pattern Matching to Good Decision Trees",
 /// by Luc Maranget.
@@ -86,6 +466,9 @@ public:
                 // Emit the expression and jump to the target
                 emitter.jump(target, emitter.emit(*rows.front().second->expr), debug);
                 case_block = cont;
+                if (!emitter.poly_defs.empty())
+                    emitter.poly_defs.back().push_back(&case_block);
+                emitter.ast_defs.push_back(&case_block);
             }
             // Map the matched patterns to arguments of the continuation
             thorin::Array<const thorin::Def*> args(bound_ptrns.size());
@@ -100,8 +483,11 @@ public:
             assert(row.first.size() == values.size());
 #endif
 
-        // Map from constructor index (e.g. literal or enumeration option index, encoded as an integer) to row.
-        std::unordered_map<const thorin::Def*, std::vector<Row>> ctors;
+        // Constructor indices (e.g. literal or enumeration option index, encoded as an integer) and their rows.
+        // Constructors are kept in the order in which they appear in the source, so that cases are always
+        // emitted in the same order, regardless of the addresses of the indices.
+        std::vector<std::pair<const thorin::Def*, std::vector<Row>>> ctors;
+        std::unordered_map<const thorin::Def*, size_t> ctor_ids;
         std::vector<Row> wildcards;
 
         auto col = pick_col();
@@ -109,8 +495,11 @@ public:
 
         // First, collect constructors
         for (auto& row : rows) {
-            if (!is_wildcard(row.first[col]))
-                ctors.emplace(emitter.ctor_index(*row.first[col]), std::vector<Row>());
+            if (is_wildcard(row.first[col]))
+                continue;
+            auto index = emitter.ctor_index(*row.first[col]);
+            if (ctor_ids.emplace(index, ctors.size()).second)
+                ctors.emplace_back(index, std::vector<Row>());
         }
 
         // Then, build the new rows for each constructor case
@@ -134,7 +523,7 @@ public:
                 remove_col(row.first, col);
                 if (enum_ptrn && enum_ptrn->arg)
                     row.first.push_back(enum_ptrn->arg.get());
-                ctors[emitter.ctor_index(*ptrn)].emplace_back(std::move(row));
+                ctors[ctor_ids[emitter.ctor_index(*ptrn)]].second.emplace_back(std::move(row));
             }
         }
 
@@ -169,7 +558,7 @@ public:
 
             if (emitter.state.cont) {
                 auto index = enum_type
-                    ? emitter.world.extract(values[col].first, thorin::u32(0))
+                    ? enum_tag(emitter, values[col].second, values[col].first, debug_info(match))
                     : values[col].first;
                 emitter.state.cont->match(
                     index, otherwise,
@@ -177,11 +566,11 @@ public:
                     no_default ? targets.skip_back() : targets.ref(),
                     debug_info(match));
             }
-            auto variant = enum_type ? emitter.world.extract(values[col].first, thorin::u32(1)) : nullptr;
+            auto matched_value = values[col];
             remove_col(values, col);
 
             for (size_t i = 0, n = targets.size(); i < n; ++i) {
-                auto& rows = ctors[defs[i]];
+                auto& rows = ctors[i].second;
                 auto _ = emitter.save_state();
                 emitter.enter(i == n - 1 && no_default ? otherwise : targets[i]);
 
@@ -192,7 +581,7 @@ public:
                     // If the constructor refers to an option that has a parameter,
                     // we need to extract it and add it to the values.
                     if (!is_unit_type(type))
-                        new_values.emplace_back(emitter.world.cast(type->convert(emitter), variant), type);
+                        new_values.emplace_back(enum_payload(emitter, matched_value.second, matched_value.first, type, debug_info(match)), type);
                 }
 
                 PtrnCompiler(emitter, match, std::move(rows), std::move(new_values), matched_values).compile(target);
@@ -346,7 +735,8 @@ private:
             // Expand the value to match against
             std::vector<Value> new_values(member_count);
             for (size_t j = 0; j < member_count; ++j) {
-                new_values[j].first  = emitter.world.extract(values[i].first, j, debug_info(*match.arg));
+                new_values[j].first  = emitter.world.extract(values[i].first,
+                    struct_type ? field_index(struct_type->decl, j) : j, debug_info(*match.arg));
                 new_values[j].second =
                     type_app    ? type_app->member_type(j)    :
                     struct_type ? struct_type->member_type(j) :
@@ -397,11 +787,134 @@ void PtrnCompiler::dump() const {
 }
 // GCOV_EXCL_STOP
 
+static size_t count_unreachable_decls(const ast::ModDecl& mod) {
+    size_t count = 0;
+    for (auto& decl : mod.decls) {
+        if (auto mod_decl = decl->isa<ast::ModDecl>())
+            count += count_unreachable_decls(*mod_decl);
+        else if (auto fn_decl = decl->isa<ast::FnDecl>(); fn_decl && !fn_decl->type_params && !fn_decl->def)
+            count++;
+        else if (decl->isa<ast::StaticDecl>() && !decl->def)
+            count++;
+    }
+    return count;
+}
+
 bool Emitter::run(const ast::ModDecl& mod) {
     mod.emit(*this);
+    if (only_reachable) {
+        if (auto count = count_unreachable_decls(mod))
+            note("{} unreachable declaration(s) skipped", count);
+    }
+    if (mono_report)
+        report_mono_fns();
     return errors == 0;
 }
 
+/// Reports the calls to functions that are only lowered in host code, in a world that contains the code of a
+/// device backend. Placeholders (see `LLVMHints`) are only replaced when hints are applied to the host module,
+/// and LLVM intrinsics are only available in backends that generate LLVM IR (given by the last argument).
+/// Those are also the only backends that accept the markers of aligned structures (see `StructType::convert`).
+bool Emitter::check_device_code(thorin::World& device_world, const std::string& backend, bool is_llvm_backend) {
+    std::unordered_set<std::string> reported;
+    std::unordered_set<size_t> reported_aligns;
+    std::unordered_set<const thorin::Type*> visited_types;
+    std::unordered_set<const thorin::Def*> visited_defs;
+
+    std::function<void (const thorin::Type*)> check_type = [&] (const thorin::Type* type) {
+        if (!visited_types.insert(type).second)
+            return;
+        if (auto array_type = type->isa<thorin::DefiniteArrayType>(); array_type && array_type->dim() == 0) {
+            auto prim_type = array_type->elem_type()->isa<thorin::PrimType>();
+            if (auto it = prim_type ? align_locs.find(prim_type->length()) : align_locs.end(); it != align_locs.end()) {
+                if (reported_aligns.insert(it->first).second)
+                    error(it->second, "aligned structures cannot be used in device code for the {} backend", backend);
+            }
+        }
+        for (auto op : type->ops())
+            check_type(op);
+    };
+    // Continuations are checked on their own, which stops the traversal at calls
+    std::function<void (const thorin::Def*)> check_def = [&] (const thorin::Def* def) {
+        if (!visited_defs.insert(def).second)
+            return;
+        check_type(def->type());
+        if (!def->isa_continuation()) {
+            for (auto op : def->ops())
+                check_def(op);
+        }
+    };
+
+    for (auto cont : device_world.copy_continuations()) {
+        if (!is_llvm_backend && !align_locs.empty()) {
+            check_type(cont->type());
+            for (auto op : cont->ops())
+                check_def(op);
+        }
+        auto it = host_only_fns.find(cont->name());
+        if (it == host_only_fns.end() || (is_llvm_backend && it->first.compare(0, 5, "llvm.") == 0))
+            continue;
+        if (reported.insert(it->first).second)
+            error(it->second.second, "{} cannot be used in device code for the {} backend", it->second.first, backend);
+    }
+    return reported.empty() && reported_aligns.empty();
+}
+
+void Emitter::report_mono_fns() {
+    struct Instance {
+        const MonoFn* mono_fn;
+        const thorin::Continuation* cont;
+        size_t conts, defs;
+    };
+    struct Group {
+        const ast::FnDecl* decl;
+        std::vector<Instance> instances;
+        size_t defs = 0;
+    };
+
+    std::unordered_map<const ast::FnDecl*, Group> groups;
+    for (auto& [mono_fn, cont] : mono_fns) {
+        thorin::Scope scope(cont);
+        size_t conts = 0;
+        for (auto def : scope.defs()) {
+            if (def->isa_continuation())
+                conts++;
+        }
+        auto& group = groups[mono_fn.decl];
+        group.decl = mono_fn.decl;
+        group.instances.push_back(Instance { &mono_fn, cont, conts, scope.defs().size() });
+        group.defs += scope.defs().size();
+    }
+
+    // Sort by decreasing size, and use the order of emission to break ties
+    std::vector<Group*> sorted;
+    for (auto& [_, group] : groups) {
+        std::sort(group.instances.begin(), group.instances.end(), [] (auto& a, auto& b) {
+            return a.defs != b.defs ? a.defs > b.defs : a.cont->gid() < b.cont->gid();
+        });
+        sorted.push_back(&group);
+    }
+    std::sort(sorted.begin(), sorted.end(), [] (auto a, auto b) {
+        return a->defs != b->defs ? a->defs > b->defs : a->instances.front().cont->gid() < b->instances.front().cont->gid();
+    });
+
+    log::out << "monomorphization report:\n";
+    for (auto group : sorted) {
+        log::format(log::out, "  {} ({}): {} instance(s), {} def(s)\n",
+            group->decl->id.name, group->decl->loc, group->instances.size(), group->defs);
+        for (auto& instance : group->instances) {
+            log::out << "    [";
+            auto& type_args = instance.mono_fn->type_args;
+            for (size_t i = 0, n = type_args.size(); i < n; ++i)
+                log::out << *type_args[i] << (i != n - 1 ? ", " : "");
+            log::out << "]";
+            if (auto it = mono_locs.find(instance.cont); it != mono_locs.end())
+                log::out << " at " << it->second;
+            log::format(log::out, ": {} continuation(s), {} def(s)\n", instance.conts, instance.defs);
+        }
+    }
+}
+
 thorin::Continuation* Emitter::basic_block(thorin::Debug debug) {
     return world.continuation(world.fn_type(), debug);
 }
@@ -414,6 +927,48 @@ thorin::Continuation* Emitter::basic_block_with_mem(const thorin::Type* param, t
     return world.continuation(continuation_type_with_mem(param), debug);
 }
 
+thorin::Continuation* Emitter::join_block(
+    const thorin::Type* param,
+    const std::vector<const ast::PtrnDecl*>& written_vars,
+    thorin::Debug debug)
+{
+    // Promoted variables that are written to before reaching the join point
+    // are passed as additional parameters, after the regular ones.
+    std::vector<const ast::PtrnDecl*> vars;
+    for (auto var : written_vars) {
+        if (state.vars.count(var))
+            vars.push_back(var);
+    }
+    if (vars.empty())
+        return basic_block_with_mem(param, debug);
+    auto fn_type = continuation_type_with_mem(param);
+    thorin::Array<const thorin::Type*> types(fn_type->num_ops() + vars.size());
+    for (size_t i = 0, n = fn_type->num_ops(); i < n; ++i)
+        types[i] = fn_type->op(i);
+    for (size_t i = 0, n = vars.size(); i < n; ++i)
+        types[fn_type->num_ops() + i] = vars[i]->type->as<RefType>()->pointee->convert(*this);
+    auto cont = world.continuation(world.fn_type(types), debug);
+    join_vars.emplace(cont, std::move(vars));
+    return cont;
+}
+
+const thorin::Def* Emitter::forward_vars(const thorin::Def* join) {
+    // Creates a continuation with the type of the join point minus the
+    // promoted variables, which forwards their current values to it.
+    auto it = join_vars.find(join);
+    if (it == join_vars.end())
+        return join;
+    auto fn_type = join->type()->as<thorin::FnType>();
+    thorin::Array<const thorin::Type*> types(fn_type->num_ops() - it->second.size());
+    for (size_t i = 0, n = types.size(); i < n; ++i)
+        types[i] = fn_type->op(i);
+    auto _ = save_state();
+    auto cont = world.continuation(world.fn_type(types), thorin::Debug("forward"));
+    enter(cont);
+    jump(join, tuple_from_params(cont));
+    return cont;
+}
+
 const thorin::Def* Emitter::ctor_index(const EnumType* enum_type, size_t index) {
     return
         enum_type->member_count() < (uintmax_t(1) <<  8) ? world.literal_pu8 (index, {}) :
@@ -463,9 +1018,12 @@ const thorin::FnType* Emitter::function_type_with_mem(const thorin::Type* from,
 const thorin::Def* Emitter::tuple_from_params(thorin::Continuation* cont, bool ret) {
     // One level of tuples are flattened when emitting functions.
     // Here, we recreate that tuple from individual parameters.
-    if (cont->num_params() == (ret ? 3 : 2))
+    auto num_params = cont->num_params();
+    if (auto it = join_vars.find(cont); it != join_vars.end())
+        num_params -= it->second.size();
+    if (num_params == (ret ? 3 : 2))
         return cont->param(1);
-    thorin::Array<const thorin::Def*> ops(cont->num_params() - (ret ? 2 : 1));
+    thorin::Array<const thorin::Def*> ops(num_params - (ret ? 2 : 1));
     for (size_t i = 0, n = ops.size(); i < n; ++i)
         ops[i] = cont->param(i + 1);
     return world.tuple(ops);
@@ -485,20 +1043,33 @@ std::vector<const thorin::Def*> Emitter::call_args(const thorin::Def* mem, const
     return ops;
 }
 
+std::vector<const thorin::Def*> Emitter::join_args(const thorin::Def* callee, std::vector<const thorin::Def*>&& args) {
+    // Append the current values of the promoted variables expected by a join point
+    if (auto it = join_vars.find(callee); it != join_vars.end()) {
+        for (auto var : it->second)
+            args.push_back(state.vars.at(var));
+    }
+    return std::move(args);
+}
+
 void Emitter::enter(thorin::Continuation* cont) {
     state.cont = cont;
     if (cont->num_params() > 0)
         state.mem = cont->param(0);
+    if (auto it = join_vars.find(cont); it != join_vars.end()) {
+        auto first = cont->num_params() - it->second.size();
+        for (size_t i = 0, n = it->second.size(); i < n; ++i)
+            state.vars[it->second[i]] = cont->param(first + i);
+    }
 }
 
 void Emitter::jump(const thorin::Def* callee, thorin::Debug debug) {
     if (!state.cont)
         return;
     auto num_params = callee->type()->as<thorin::FnType>()->num_ops();
-    if (num_params == 1) {
-        state.cont->jump(callee, { state.mem }, debug);
+    if (num_params > 0) {
+        state.cont->jump(callee, join_args(callee, { state.mem }), debug);
     } else {
-        assert(num_params == 0);
         state.cont->jump(callee, {}, debug);
     }
     state.cont = nullptr;
@@ -507,7 +1078,7 @@ void Emitter::jump(const thorin::Def* callee, thorin::Debug debug) {
 void Emitter::jump(const thorin::Def* callee, const thorin::Def* arg, thorin::Debug debug) {
     if (!state.cont)
         return;
-    state.cont->jump(callee, call_args(state.mem, arg), debug);
+    state.cont->jump(callee, join_args(callee, call_args(state.mem, arg)), debug);
     state.cont = nullptr;
 }
 
@@ -614,11 +1185,36 @@ const thorin::Def* Emitter::down_cast(const thorin::Def* def, const Type* from,
     return def;
 }
 
+const thorin::Def* Emitter::layout_cast(const thorin::Def* def, const Type* from, const Type* to, thorin::Debug debug) {
+    // Converts between types that only differ by the pointee of some pointer types
+    if (to == from)
+        return def;
+    else if (from->isa<PtrType>())
+        return world.bitcast(to->convert(*this), def, debug);
+    else if (auto from_tuple_type = from->isa<TupleType>()) {
+        thorin::Array<const thorin::Def*> ops(from_tuple_type->args.size());
+        for (size_t i = 0, n = ops.size(); i < n; ++i)
+            ops[i] = layout_cast(world.extract(def, i, debug), from_tuple_type->args[i], to->as<TupleType>()->args[i], debug);
+        return world.tuple(ops, debug);
+    } else if (auto from_fn_type = from->isa<FnType>()) {
+        auto _ = save_state();
+        auto cont = world.continuation(to->convert(*this)->as<thorin::FnType>(), debug);
+        enter(cont);
+        auto param = layout_cast(tuple_from_params(cont, true), to->as<FnType>()->dom, from_fn_type->dom, debug);
+        auto value = layout_cast(call(def, param, debug), from_fn_type->codom, to->as<FnType>()->codom, debug);
+        jump(cont->params().back(), value, debug);
+        return cont;
+    }
+    assert(false);
+    return def;
+}
+
 const thorin::Def* Emitter::emit(const ast::Node& node) {
     if (node.def)
         return node.def;
     if (!poly_defs.empty())
         poly_defs.back().push_back(&node.def);
+    ast_defs.push_back(&node.def);
     return node.def = node.emit(*this);
 }
 
@@ -629,17 +1225,33 @@ void Emitter::emit(const ast::Ptrn& ptrn, const thorin::Def* value) {
 
 void Emitter::bind(const ast::IdPtrn& id_ptrn, const thorin::Def* value) {
     if (id_ptrn.decl->is_mut) {
-        auto ptr = alloc(value->type(), debug_info(*id_ptrn.decl));
-        store(ptr, value);
-        id_ptrn.decl->def = ptr;
+        if (id_ptrn.decl->is_ssa)
+            state.vars[id_ptrn.decl.get()] = value;
+        else {
+            auto ptr = alloc(value->type(), debug_info(*id_ptrn.decl));
+            store(ptr, value);
+            id_ptrn.decl->def = ptr;
+            ast_defs.push_back(&id_ptrn.decl->def);
+        }
         if (!id_ptrn.decl->written_to)
             warn(id_ptrn.loc, "mutable variable '{}' is never written to", id_ptrn.decl->id.name);
     } else {
         id_ptrn.decl->def = value;
+        ast_defs.push_back(&id_ptrn.decl->def);
         value->debug().set(id_ptrn.decl->id.name);
     }
 }
 
+const ast::PtrnDecl* Emitter::ssa_var(const ast::Expr& expr) {
+    // Returns the declaration of the promoted variable referenced by the given expression, if any
+    if (auto path_expr = expr.isa<ast::PathExpr>(); path_expr && path_expr->path.symbol) {
+        auto decl = path_expr->path.symbol->decls.front()->isa<ast::PtrnDecl>();
+        if (decl && state.vars.count(decl))
+            return decl;
+    }
+    return nullptr;
+}
+
 const thorin::Def* Emitter::emit(const ast::Node& node, const Literal& lit) {
     if (auto prim_type = node.type->isa<artic::PrimType>()) {
         switch (prim_type->tag) {
@@ -672,7 +1284,61 @@ const thorin::Def* Emitter::emit(const ast::Node& node, const Literal& lit) {
     }
 }
 
+/// Returns the `atomicrmw` operation (as numbered by LLVM) performed by the given atomic builtin, or -1.
+static int atomic_binop(const std::string& name, bool is_signed) {
+    if (name == "atomic_xchg") return 0;
+    if (name == "atomic_add")  return 1;
+    if (name == "atomic_sub")  return 2;
+    if (name == "atomic_and")  return 3;
+    if (name == "atomic_or")   return 5;
+    if (name == "atomic_xor")  return 6;
+    if (name == "atomic_max")  return is_signed ? 7 : 9;
+    if (name == "atomic_min")  return is_signed ? 8 : 10;
+    return -1;
+}
+
+static bool is_signed_type(const Type* type) {
+    if (auto array_type = type->isa<SizedArrayType>())
+        return is_signed_type(array_type->elem);
+    return
+        is_prim_type(type, ast::PrimType::I8)  || is_prim_type(type, ast::PrimType::I16) ||
+        is_prim_type(type, ast::PrimType::I32) || is_prim_type(type, ast::PrimType::I64);
+}
+
 const thorin::Def* Emitter::builtin(const ast::FnDecl& fn_decl, thorin::Continuation* cont) {
+    // Type of the first argument, with type variables replaced by their current value
+    auto fn_type = (fn_decl.type_params ? fn_decl.type->as<ForallType>()->body : fn_decl.type)->as<FnType>();
+    auto arg_type = fn_type->dom->replace(type_vars);
+
+    // The type checker cannot check instances created with the type variables of another polymorphic function
+    if (auto instance_type = fn_type->replace(type_vars); !is_valid_builtin(cont->name(), instance_type)) {
+        error(fn_decl.loc, "invalid instance of built-in function '{}' with type '{}'", cont->name(), *instance_type);
+        return cont;
+    }
+    if (auto tuple_type = arg_type->isa<TupleType>(); tuple_type && !tuple_type->args.empty())
+        arg_type = tuple_type->args[0];
+
+    // Name of the overloaded LLVM intrinsic for the type of the first argument
+    auto overloaded = [&] (const std::string& name) {
+        return name + "." + intrinsic_suffix(arg_type);
+    };
+    // Calls the LLVM (or Thorin) intrinsic with the given name and arguments, and returns to the caller of the builtin
+    auto call_intrinsic = [&] (const std::string& name, std::vector<const thorin::Def*>&& args, bool is_thorin = false) {
+        args.insert(args.begin(), cont->param(0));
+        args.push_back(cont->params().back());
+        thorin::Array<const thorin::Type*> types(args.size());
+        for (size_t i = 0, n = args.size(); i < n; ++i)
+            types[i] = args[i]->type();
+        auto intrinsic = world.continuation(world.fn_type(types), thorin::Debug(name));
+        if (is_thorin)
+            intrinsic->set_intrinsic();
+        else {
+            intrinsic->cc() = thorin::CC::C;
+            host_only_fns.emplace(name, std::pair("built-in function '" + cont->name() + "'", fn_decl.loc));
+        }
+        cont->jump(intrinsic, args, debug_info(fn_decl));
+    };
+
     if (cont->name() == "alignof") {
         auto target_type = fn_decl.type_params->params[0]->type->convert(*this);
         cont->jump(cont->params().back(), { cont->param(0), world.align_of(target_type) }, debug_info(fn_decl));
@@ -696,6 +1362,88 @@ const thorin::Def* Emitter::builtin(const ast::FnDecl& fn_decl, thorin::Continua
     } else if (cont->name() == "undef") {
         auto target_type = fn_decl.type_params->params[0]->type->convert(*this);
         cont->jump(cont->params().back(), call_args(cont->param(0), world.bottom(target_type)), debug_info(fn_decl));
+    } else if (cont->name() == "popcount") {
+        call_intrinsic(overloaded("llvm.ctpop"), { cont->param(1) });
+    } else if (cont->name() == "clz") {
+        call_intrinsic(overloaded("llvm.ctlz"), { cont->param(1), world.literal_bool(false, {}) });
+    } else if (cont->name() == "ctz") {
+        call_intrinsic(overloaded("llvm.cttz"), { cont->param(1), world.literal_bool(false, {}) });
+    } else if (cont->name() == "bswap") {
+        call_intrinsic(overloaded("llvm.bswap"), { cont->param(1) });
+    } else if (cont->name() == "rotl") {
+        // Rotations are funnel shifts with the same value as both inputs
+        call_intrinsic(overloaded("llvm.fshl"), { cont->param(1), cont->param(1), cont->param(2) });
+    } else if (cont->name() == "rotr") {
+        call_intrinsic(overloaded("llvm.fshr"), { cont->param(1), cont->param(1), cont->param(2) });
+    } else if (cont->name() == "fma") {
+        call_intrinsic(overloaded("llvm.fma"), { cont->param(1), cont->param(2), cont->param(3) });
+    } else if (cont->name() == "min" || cont->name() == "max") {
+        auto a = cont->param(1), b = cont->param(2);
+        auto cond = cont->name() == "min" ? world.cmp_lt(a, b) : world.cmp_gt(a, b);
+        cont->jump(cont->params().back(), call_args(cont->param(0), world.select(cond, a, b)), debug_info(fn_decl));
+    } else if (cont->name() == "add_sat") {
+        call_intrinsic(overloaded(is_signed_type(arg_type) ? "llvm.sadd.sat" : "llvm.uadd.sat"), { cont->param(1), cont->param(2) });
+    } else if (cont->name() == "sub_sat") {
+        call_intrinsic(overloaded(is_signed_type(arg_type) ? "llvm.ssub.sat" : "llvm.usub.sat"), { cont->param(1), cont->param(2) });
+    } else if (cont->name() == "mul_wide") {
+        // Extends both operands to the (larger) return type before multiplying
+        auto target_type = fn_type->codom->convert(*this);
+        auto a = world.cast(target_type, cont->param(1));
+        auto b = world.cast(target_type, cont->param(2));
+        cont->jump(cont->params().back(), call_args(cont->param(0), world.arithop_mul(a, b)), debug_info(fn_decl));
+    } else if (cont->name() == "prefetch") {
+        // The name of `llvm.prefetch` depends on the LLVM pointer type, which is only known once the
+        // module is generated: Prefetches are calls to placeholder functions (see `LLVMHints::apply`).
+        // The type checker only accepts literals for the access kind and the locality,
+        // which become the constants required by LLVM once this continuation is specialized.
+        call_intrinsic(LLVMHints::prefetch_prefix + cont->unique_name(), {
+            cont->param(1),
+            world.cast(world.type_qs32(), cont->param(2)),
+            world.cast(world.type_qs32(), cont->param(3))
+        });
+    } else if (cont->name() == "assume_aligned") {
+        // Uses the assumption `(ptr & (align - 1)) == 0`, which LLVM turns into alignment information
+        auto ptr = cont->param(1);
+        auto mask = world.arithop_sub(world.cast(world.type_pu64(), cont->param(2)), world.literal_pu64(1, {}));
+        auto cond = world.cmp_eq(world.arithop_and(world.cast(world.type_pu64(), ptr), mask), world.literal_pu64(0, {}));
+        auto assume = world.continuation(
+            world.fn_type({ world.mem_type(), world.type_bool(), world.fn_type({ world.mem_type() }) }),
+            thorin::Debug("llvm.assume"));
+        assume->cc() = thorin::CC::C;
+        host_only_fns.emplace(assume->name(), std::pair("built-in function 'assume_aligned'", fn_decl.loc));
+        auto next = basic_block_with_mem(debug_info(fn_decl));
+        cont->jump(assume, { cont->param(0), cond, next }, debug_info(fn_decl));
+        next->jump(cont->params().back(), { next->param(0), ptr }, debug_info(fn_decl));
+    } else if (cont->name() == "load_nt") {
+        // Thorin memory operations cannot carry the non-temporal hint: Streaming accesses are calls to
+        // placeholder functions, replaced by loads and stores with `!nontemporal` (see `LLVMHints::apply`).
+        call_intrinsic(LLVMHints::nontemporal_prefix + ("load." + cont->unique_name()), { cont->param(1) });
+    } else if (cont->name() == "store_nt") {
+        call_intrinsic(LLVMHints::nontemporal_prefix + ("store." + cont->unique_name()), { cont->param(1), cont->param(2) });
+    } else if (cont->name() == "fence" || cont->name().compare(0, 7, "atomic_") == 0) {
+        // Atomic operations are lowered to the corresponding Thorin intrinsics,
+        // which take the memory orders as LLVM orderings and a synchronization scope.
+        // The type checker only accepts literal orders, which become constants
+        // once this continuation is specialized at its call sites.
+        auto order = [&] (size_t i) { return world.cast(world.type_pu32(), cont->param(i)); };
+        auto scope = world.bitcast(
+            world.ptr_type(world.indefinite_array_type(world.type_pu8())),
+            world.global(world.definite_array({ world.literal_pu8(0, {}) }), false));
+        if (cont->name() == "fence") {
+            call_intrinsic("fence", { order(1), scope }, true);
+        } else {
+            auto pointee = arg_type->as<PtrType>()->pointee;
+            if (cont->name() == "atomic_load")
+                call_intrinsic("atomic_load", { cont->param(1), order(2), scope }, true);
+            else if (cont->name() == "atomic_store")
+                call_intrinsic("atomic_store", { cont->param(1), cont->param(2), order(3), scope }, true);
+            else if (cont->name() == "atomic_cas")
+                call_intrinsic("cmpxchg", { cont->param(1), cont->param(2), cont->param(3), order(4), order(5), scope }, true);
+            else {
+                auto binop = world.literal_pu32(atomic_binop(cont->name(), is_signed_type(pointee)), {});
+                call_intrinsic("atomic", { binop, cont->param(1), cont->param(2), order(3), scope }, true);
+            }
+        }
     } else {
         assert(false);
     }
@@ -732,6 +1480,8 @@ const thorin::Def* Path::emit(Emitter& emitter) const {
             }
             auto def = emitter.emit(*decl);
             if (!elems[i].inferred_args.empty()) {
+                if (auto cont = def->isa_continuation())
+                    emitter.mono_locs.emplace(cont, loc);
                 // Polymorphic nodes are emitted with the map from type variable
                 // to concrete type, which means that the emitted node cannot be
                 // kept around: Another instantiation may be using a different map,
@@ -747,26 +1497,19 @@ const thorin::Def* Path::emit(Emitter& emitter) const {
             Emitter::Ctor ctor { elems[i + 1].index, type_app ? type_app->replace(emitter.type_vars) : enum_type };
             if (auto it = emitter.variant_ctors.find(ctor); it != emitter.variant_ctors.end())
                 return it->second;
-            auto index = emitter.ctor_index(enum_type, ctor.index);
-            auto converted_type = (type_app
-                ? type_app->convert(emitter)
-                : enum_type->convert(emitter))->as<thorin::StructType>();
-            auto variant_type = converted_type->op(1)->as<thorin::VariantType>();
+            auto type = type_app ? type_app->as<artic::Type>() : enum_type;
             auto param_type = type_app
                 ? type_app->member_type(ctor.index)
                 : enum_type->member_type(ctor.index);
             if (is_unit_type(param_type)) {
                 // This is a constructor without parameters
-                return emitter.variant_ctors[ctor] =
-                    emitter.world.struct_agg(converted_type, {
-                        index, emitter.world.variant(variant_type, emitter.world.tuple({})) });
+                return emitter.variant_ctors[ctor] = make_enum(emitter, type, ctor.index, nullptr, debug_info(*this));
             } else {
                 // This is a constructor with parameters: return a function
                 auto cont = emitter.world.continuation(
-                    emitter.function_type_with_mem(param_type->convert(emitter), converted_type),
+                    emitter.function_type_with_mem(param_type->convert(emitter), type->convert(emitter)),
                     debug_info(*enum_type->decl.options[ctor.index]));
-                auto ret_value = emitter.world.struct_agg(converted_type, {
-                    index, emitter.world.variant(variant_type, emitter.tuple_from_params(cont, true)) });
+                auto ret_value = make_enum(emitter, type, ctor.index, emitter.tuple_from_params(cont, true), debug_info(*this));
                 cont->jump(cont->params().back(), { cont->param(0), ret_value });
                 cont->set_all_true_filter();
                 return emitter.variant_ctors[ctor] = cont;
@@ -825,6 +1568,8 @@ const thorin::Def* ArrayExpr::emit(Emitter& emitter) const {
     thorin::Array<const thorin::Def*> ops(elems.size());
     for (size_t i = 0, n = elems.size(); i < n; ++i)
         ops[i] = emitter.emit(*elems[i]);
+    if (soa_elem_type(emitter, type))
+        return soa_array(emitter, type, ops, debug_info(*this));
     return is_simd
         ? emitter.world.vector(ops, debug_info(*this))
         : emitter.world.definite_array(ops, debug_info(*this));
@@ -832,6 +1577,8 @@ const thorin::Def* ArrayExpr::emit(Emitter& emitter) const {
 
 const thorin::Def* RepeatArrayExpr::emit(Emitter& emitter) const {
     thorin::Array<const thorin::Def*> ops(size, emitter.emit(*elem));
+    if (soa_elem_type(emitter, type))
+        return soa_array(emitter, type, ops, debug_info(*this));
     return is_simd
         ? emitter.world.vector(ops, debug_info(*this))
         : emitter.world.definite_array(ops, debug_info(*this));
@@ -842,26 +1589,25 @@ const thorin::Def* FieldExpr::emit(Emitter& emitter) const {
 }
 
 const thorin::Def* StructExpr::emit(Emitter& emitter) const {
+    auto [_, struct_type] = match_app<artic::StructType>(Node::type);
+    auto& decl = struct_type->decl;
     if (expr) {
         auto value = emitter.emit(*expr);
         for (auto& field : fields)
-            value = emitter.world.insert(value, field->index, emitter.emit(*field), debug_info(*this));
+            value = emitter.world.insert(value, field_index(decl, field->index), emitter.emit(*field), debug_info(*this));
         return value;
     } else {
-        auto [_, struct_type] = match_app<artic::StructType>(Node::type);
         thorin::Array<const thorin::Def*> ops(struct_type->member_count(), nullptr);
         for (size_t i = 0, n = fields.size(); i < n; ++i)
             ops[fields[i]->index] = emitter.emit(*fields[i]);
         // Use default values for missing fields
         for (size_t i = 0, n = ops.size(); i < n; ++i) {
             if (!ops[i]) {
-                assert(struct_type->decl.fields[i]->init);
-                ops[i] = emitter.emit(*struct_type->decl.fields[i]->init);
+                assert(decl.fields[i]->init);
+                ops[i] = emitter.emit(*decl.fields[i]->init);
             }
         }
-        return emitter.world.struct_agg(
-            Node::type->convert(emitter)->as<thorin::StructType>(),
-            ops, debug_info(*this));
+        return make_struct(emitter, Node::type, ops, debug_info(*this));
     }
 }
 
@@ -890,9 +1636,13 @@ const thorin::Def* FnExpr::emit(Emitter& emitter) const {
 }
 
 const thorin::Def* BlockExpr::emit(Emitter& emitter) const {
+    auto fast_math = emitter.state.fast_math;
+    if (auto flags = fast_math_flags(attrs.get()); !flags.empty())
+        emitter.state.fast_math = flags;
     const thorin::Def* last = nullptr;
     for (auto& stmt : stmts)
         last = emitter.emit(*stmt);
+    emitter.state.fast_math = fast_math;
     return last && !last_semi ? last : emitter.world.tuple({});
 }
 
@@ -905,6 +1655,16 @@ const thorin::Def* CallExpr::emit(Emitter& emitter) const {
             return emitter.no_ret();
         }
         return emitter.call(fn, value, debug_info(*this));
+    } else if (auto elem_type = soa_elem_type(emitter, callee->type)) {
+        // References to elements of `#[soa]` arrays are handled by their users
+        assert(!type->isa<artic::RefType>());
+        auto array = emitter.emit(*callee);
+        auto index = emitter.emit(*arg);
+        auto [_, struct_type] = match_app<artic::StructType>(elem_type);
+        thorin::Array<const thorin::Def*> fields(struct_type->member_count());
+        for (size_t i = 0, n = fields.size(); i < n; ++i)
+            fields[i] = emitter.world.extract(emitter.world.extract(array, i, debug_info(*this)), index, debug_info(*this));
+        return make_struct(emitter, elem_type, fields, debug_info(*this));
     } else {
         auto array = emitter.emit(*callee);
         auto index = emitter.emit(*arg);
@@ -915,29 +1675,41 @@ const thorin::Def* CallExpr::emit(Emitter& emitter) const {
 }
 
 const thorin::Def* ProjExpr::emit(Emitter& emitter) const {
+    if (auto call_expr = soa_elem_ref(emitter, *expr))
+        return soa_field_ptrs(emitter, *call_expr)[index];
+    auto expr_type = expr->type;
+    if (auto ref_type = expr_type->isa<RefType>())
+        expr_type = ref_type->pointee;
+    if (auto ptr_type = expr_type->isa<artic::PtrType>())
+        expr_type = ptr_type->pointee;
+    auto [_, struct_type] = match_app<artic::StructType>(expr_type);
+    auto field_index = artic::field_index(struct_type->decl, index);
     if (type->isa<RefType>()) {
         return emitter.world.lea(
             emitter.emit(*expr),
-            emitter.world.literal_pu64(index, {}),
+            emitter.world.literal_pu64(field_index, {}),
             debug_info(*this));
     }
-    return emitter.world.extract(emitter.emit(*expr), index, debug_info(*this));
+    return emitter.world.extract(emitter.emit(*expr), field_index, debug_info(*this));
 }
 
 const thorin::Def* IfExpr::emit(Emitter& emitter) const {
     auto join_true  = emitter.basic_block_with_mem(debug_info(*this, "join_true"));
     auto join_false = emitter.basic_block_with_mem(debug_info(*this, "join_false"));
     cond->emit(emitter, join_true, join_false);
+    // Both branches start with the values of promoted variables after the condition
+    auto vars = emitter.state.vars;
 
     // This can happen if both branches call a continuation.
     thorin::Continuation* join = nullptr;
     if (!type->isa<artic::NoRetType>())
-        join = emitter.basic_block_with_mem(type->convert(emitter), debug_info(*this, "if_join"));
+        join = emitter.join_block(type->convert(emitter), written_vars, debug_info(*this, "if_join"));
 
     emitter.enter(join_true);
     auto true_value = emitter.emit(*if_true);
     if (join) emitter.jump(join, true_value);
 
+    emitter.state.vars = std::move(vars);
     emitter.enter(join_false);
     auto false_value = if_false ? emitter.emit(*if_false) : emitter.world.tuple({});
     if (join) emitter.jump(join, false_value);
@@ -950,7 +1722,7 @@ const thorin::Def* IfExpr::emit(Emitter& emitter) const {
 }
 
 const thorin::Def* MatchExpr::emit(Emitter& emitter) const {
-    auto join = emitter.basic_block_with_mem(type->convert(emitter), debug_info(*this, "match_join"));
+    auto join = emitter.join_block(type->convert(emitter), written_vars, debug_info(*this, "match_join"));
     for (auto& case_ : cases)
         case_->collect_bound_ptrns();
     std::unordered_map<const IdPtrn*, const thorin::Def*> matched_values;
@@ -963,29 +1735,60 @@ const thorin::Def* MatchExpr::emit(Emitter& emitter) const {
     return emitter.tuple_from_params(join);
 }
 
+/// Records the LLVM loop metadata requested by the attributes of a loop.
+static void add_loop_hints(Emitter& emitter, const ast::AttrList& attrs, const thorin::Continuation* cont) {
+    std::vector<std::pair<std::string, std::optional<unsigned>>> md;
+    for (auto& attr : attrs.args) {
+        if (auto lit_attr = attr->isa<ast::LiteralAttr>()) {
+            auto count = unsigned(lit_attr->lit.as_integer());
+            if (attr->name == "unroll")
+                md.emplace_back("llvm.loop.unroll.count", count);
+            else if (attr->name == "interleave")
+                md.emplace_back("llvm.loop.interleave.count", count);
+            else if (attr->name == "vectorize") {
+                md.emplace_back("llvm.loop.vectorize.enable", 1);
+                md.emplace_back("llvm.loop.vectorize.width", count);
+            }
+        } else if (attr->name == "unroll")
+            md.emplace_back("llvm.loop.unroll.full", std::nullopt);
+        else if (attr->name == "no_unroll")
+            md.emplace_back("llvm.loop.unroll.disable", std::nullopt);
+        else if (attr->name == "vectorize")
+            md.emplace_back("llvm.loop.vectorize.enable", 1);
+    }
+    if (!md.empty())
+        emitter.hints.loop_md[cont] = std::move(md);
+}
+
 const thorin::Def* WhileExpr::emit(Emitter& emitter) const {
-    auto while_head = emitter.basic_block_with_mem(debug_info(*this, "while_head"));
+    auto while_head = emitter.join_block(emitter.world.unit(), written_vars, debug_info(*this, "while_head"));
     auto while_body = emitter.basic_block_with_mem(debug_info(*this, "while_body"));
     auto while_exit = emitter.basic_block_with_mem(debug_info(*this, "while_exit"));
-    auto while_continue = emitter.basic_block_with_mem(emitter.world.unit(), debug_info(*this, "while_continue"));
-    auto while_break    = emitter.basic_block_with_mem(emitter.world.unit(), debug_info(*this, "while_break"));
+    auto while_continue = emitter.join_block(emitter.world.unit(), written_vars, debug_info(*this, "while_continue"));
+    auto while_break    = emitter.join_block(emitter.world.unit(), written_vars, debug_info(*this, "while_break"));
     emitter.jump(while_head);
 
     emitter.enter(while_continue);
     emitter.jump(while_head);
-    emitter.enter(while_break);
-    emitter.jump(while_exit);
     break_ = while_break;
     continue_ = while_continue;
+    if (attrs)
+        add_loop_hints(emitter, *attrs, while_head);
 
     emitter.enter(while_head);
     cond->emit(emitter, while_body, while_exit);
+    auto vars = emitter.state.vars;
 
     emitter.enter(while_body);
     emitter.emit(*body);
     emitter.jump(while_head);
 
+    // Both the condition and `break` leave the loop through `while_break`,
+    // which merges the values of the promoted variables.
+    emitter.state.vars = std::move(vars);
     emitter.enter(while_exit);
+    emitter.jump(while_break, emitter.world.tuple({}));
+    emitter.enter(while_break);
     return emitter.world.tuple({});
 }
 
@@ -1005,6 +1808,8 @@ const thorin::Def* ForExpr::emit(Emitter& emitter) const {
         emitter.emit(*body_fn->param, emitter.tuple_from_params(body_cont, true));
         emitter.jump(body_cont->params().back(), emitter.emit(*body_fn->body));
     }
+    if (attrs)
+        add_loop_hints(emitter, *attrs, body_cont);
 
     // Emit the calls
     auto inner_callee = emitter.emit(*call->callee->as<CallExpr>()->callee);
@@ -1012,14 +1817,14 @@ const thorin::Def* ForExpr::emit(Emitter& emitter) const {
     return emitter.call(inner_call, emitter.emit(*call->arg), break_->as_continuation(), debug_info(*this, "outer_call"));
 }
 
-const thorin::Def* BreakExpr::emit(Emitter&) const {
+const thorin::Def* BreakExpr::emit(Emitter& emitter) const {
     assert(loop);
-    return loop->break_;
+    return emitter.forward_vars(loop->break_);
 }
 
-const thorin::Def* ContinueExpr::emit(Emitter&) const {
+const thorin::Def* ContinueExpr::emit(Emitter& emitter) const {
     assert(loop);
-    return loop->continue_;
+    return emitter.forward_vars(loop->continue_);
 }
 
 const thorin::Def* ReturnExpr::emit(Emitter&) const {
@@ -1030,14 +1835,24 @@ const thorin::Def* UnaryExpr::emit(Emitter& emitter) const {
     const thorin::Def* op = nullptr;
     const thorin::Def* ptr = nullptr;
     if (tag == AddrOf || tag == AddrOfMut) {
+        if (soa_elem_ref(emitter, *arg)) {
+            // The type checker cannot detect this in polymorphic functions, before their instantiation
+            emitter.error(loc, "cannot take the address of an element of an array of '{}' structures", "soa");
+            return emitter.world.bottom(Node::type->convert(emitter));
+        }
         auto def = emitter.emit(*arg);
         if (arg->type->isa<RefType>())
             return def;
         return emitter.addr_of(def, debug_info(*this));
     }
+    const ast::PtrnDecl* var = nullptr;
     if (is_inc() || is_dec()) {
-        ptr = emitter.emit(*arg);
-        op  = emitter.load(ptr, debug_info(*this));
+        if ((var = emitter.ssa_var(*arg)))
+            op = emitter.state.vars[var];
+        else {
+            ptr = emitter.emit(*arg);
+            op  = emitter.load(ptr, debug_info(*this));
+        }
     } else {
         op = emitter.emit(*arg);
     }
@@ -1049,28 +1864,39 @@ const thorin::Def* UnaryExpr::emit(Emitter& emitter) const {
             // The operand must be a pointer, so we return it as a reference
             res = op;
             break;
-        case Not:    res = emitter.world.arithop_not(op, debug_info(*this));   break;
-        case Minus:  res = emitter.world.arithop_minus(op, debug_info(*this)); break;
-        case Known:  res = emitter.world.known(op, debug_info(*this));         break;
-        case Forget: res = emitter.world.hlt(op, debug_info(*this));           break;
+        case Not:    res = emitter.world.arithop_not(op, debug_info(*this)); break;
+        case Known:  res = emitter.world.known(op, debug_info(*this));        break;
+        case Forget: res = emitter.world.hlt(op, debug_info(*this));          break;
+        case Minus:
+            res = fast_math_op(emitter, *this, "fneg", arg->type, op->type(), { op });
+            if (!res)
+                res = emitter.world.arithop_minus(op, debug_info(*this));
+            break;
         case PreInc:
         case PostInc: {
             auto one = emitter.world.one(op->type());
-            res = emitter.world.arithop_add(op, one, debug_info(*this));
+            res = fast_math_op(emitter, *this, "fadd", arg->type, op->type(), { op, one });
+            if (!res)
+                res = emitter.world.arithop_add(op, one, debug_info(*this));
             break;
         }
         case PreDec:
         case PostDec: {
             auto one = emitter.world.one(op->type());
-            res = emitter.world.arithop_sub(op, one, debug_info(*this));
+            res = fast_math_op(emitter, *this, "fsub", arg->type, op->type(), { op, one });
+            if (!res)
+                res = emitter.world.arithop_sub(op, one, debug_info(*this));
             break;
         }
         default:
             assert(false);
             return nullptr;
     }
-    if (ptr) {
-        emitter.store(ptr, res, debug_info(*this));
+    if (ptr || var) {
+        if (var)
+            emitter.state.vars[var] = res;
+        else
+            emitter.store(ptr, res, debug_info(*this));
         return is_postfix() ? op : res;
     }
     return res;
@@ -1113,40 +1939,64 @@ const thorin::Def* BinaryExpr::emit(Emitter& emitter) const {
         emitter.enter(join);
         return emitter.tuple_from_params(join);
     }
+    if (auto call_expr = soa_elem_ref(emitter, *left)) {
+        // Structures are only assigned as a whole, field by field for `#[soa]` arrays
+        assert(tag == Eq);
+        auto ptrs = soa_field_ptrs(emitter, *call_expr);
+        auto value = emitter.emit(*right);
+        auto [_, struct_type] = match_app<artic::StructType>(soa_elem_type(emitter, call_expr->callee->type));
+        for (size_t i = 0, n = ptrs.size(); i < n; ++i)
+            emitter.store(ptrs[i], emitter.world.extract(value, field_index(struct_type->decl, i)), debug_info(*this));
+        return emitter.world.tuple({});
+    }
     const thorin::Def* lhs = nullptr;
     const thorin::Def* ptr = nullptr;
+    const ast::PtrnDecl* var = nullptr;
     if (left->type->isa<artic::RefType>()) {
-        ptr = emitter.emit(*left);
-        lhs = emitter.load(ptr, debug_info(*this));
+        if ((var = emitter.ssa_var(*left)))
+            lhs = emitter.state.vars[var];
+        else {
+            ptr = emitter.emit(*left);
+            lhs = emitter.load(ptr, debug_info(*this));
+        }
     } else {
         lhs = emitter.emit(*left);
     }
     auto rhs = emitter.emit(*right);
     const thorin::Def* res = nullptr;
-    switch (remove_eq(tag)) {
-        case Add:   res = emitter.world.arithop_add(lhs, rhs, debug_info(*this)); break;
-        case Sub:   res = emitter.world.arithop_sub(lhs, rhs, debug_info(*this)); break;
-        case Mul:   res = emitter.world.arithop_mul(lhs, rhs, debug_info(*this)); break;
-        case Div:   res = emitter.world.arithop_div(lhs, rhs, debug_info(*this)); break;
-        case Rem:   res = emitter.world.arithop_rem(lhs, rhs, debug_info(*this)); break;
-        case And:   res = emitter.world.arithop_and(lhs, rhs, debug_info(*this)); break;
-        case Or:    res = emitter.world.arithop_or (lhs, rhs, debug_info(*this)); break;
-        case Xor:   res = emitter.world.arithop_xor(lhs, rhs, debug_info(*this)); break;
-        case LShft: res = emitter.world.arithop_shl(lhs, rhs, debug_info(*this)); break;
-        case RShft: res = emitter.world.arithop_shr(lhs, rhs, debug_info(*this)); break;
-        case CmpEq: res = emitter.world.cmp_eq(lhs, rhs, debug_info(*this)); break;
-        case CmpNE: res = emitter.world.cmp_ne(lhs, rhs, debug_info(*this)); break;
-        case CmpGT: res = emitter.world.cmp_gt(lhs, rhs, debug_info(*this)); break;
-        case CmpLT: res = emitter.world.cmp_lt(lhs, rhs, debug_info(*this)); break;
-        case CmpGE: res = emitter.world.cmp_ge(lhs, rhs, debug_info(*this)); break;
-        case CmpLE: res = emitter.world.cmp_le(lhs, rhs, debug_info(*this)); break;
-        case Eq:    res = rhs; break;
-        default:
-            assert(false);
-            return nullptr;
+    if (auto op = float_op(remove_eq(tag))) {
+        auto ret_type = has_cmp() ? Node::type->convert(emitter) : lhs->type();
+        res = fast_math_op(emitter, *this, op, left->type, ret_type, { lhs, rhs });
+    }
+    if (!res) {
+        switch (remove_eq(tag)) {
+            case Add:   res = emitter.world.arithop_add(lhs, rhs, debug_info(*this)); break;
+            case Sub:   res = emitter.world.arithop_sub(lhs, rhs, debug_info(*this)); break;
+            case Mul:   res = emitter.world.arithop_mul(lhs, rhs, debug_info(*this)); break;
+            case Div:   res = emitter.world.arithop_div(lhs, rhs, debug_info(*this)); break;
+            case Rem:   res = emitter.world.arithop_rem(lhs, rhs, debug_info(*this)); break;
+            case And:   res = emitter.world.arithop_and(lhs, rhs, debug_info(*this)); break;
+            case Or:    res = emitter.world.arithop_or (lhs, rhs, debug_info(*this)); break;
+            case Xor:   res = emitter.world.arithop_xor(lhs, rhs, debug_info(*this)); break;
+            case LShft: res = emitter.world.arithop_shl(lhs, rhs, debug_info(*this)); break;
+            case RShft: res = emitter.world.arithop_shr(lhs, rhs, debug_info(*this)); break;
+            case CmpEq: res = emitter.world.cmp_eq(lhs, rhs, debug_info(*this)); break;
+            case CmpNE: res = emitter.world.cmp_ne(lhs, rhs, debug_info(*this)); break;
+            case CmpGT: res = emitter.world.cmp_gt(lhs, rhs, debug_info(*this)); break;
+            case CmpLT: res = emitter.world.cmp_lt(lhs, rhs, debug_info(*this)); break;
+            case CmpGE: res = emitter.world.cmp_ge(lhs, rhs, debug_info(*this)); break;
+            case CmpLE: res = emitter.world.cmp_le(lhs, rhs, debug_info(*this)); break;
+            case Eq:    res = rhs; break;
+            default:
+                assert(false);
+                return nullptr;
+        }
     }
     if (has_eq()) {
-        emitter.store(ptr, res, debug_info(*this));
+        if (var)
+            emitter.state.vars[var] = res;
+        else
+            emitter.store(ptr, res, debug_info(*this));
         return emitter.world.tuple({});
     }
     return res;
@@ -1163,6 +2013,23 @@ const thorin::Def* CastExpr::emit(Emitter& emitter) const {
 }
 
 const thorin::Def* ImplicitCastExpr::emit(Emitter& emitter) const {
+    if (is_soa_array_cast(emitter, expr->type, type)) {
+        // The type checker cannot detect this in polymorphic functions, before their instantiation
+        emitter.error(loc, "cannot convert an array of '{}' structures to an unsized array", "soa");
+        return emitter.world.bottom(type->convert(emitter));
+    }
+    if (auto call_expr = soa_elem_ref(emitter, *expr)) {
+        // Elements of `#[soa]` arrays are gathered from the array of each field
+        auto ptrs = soa_field_ptrs(emitter, *call_expr);
+        thorin::Array<const thorin::Def*> fields(ptrs.size());
+        for (size_t i = 0, n = ptrs.size(); i < n; ++i)
+            fields[i] = emitter.load(ptrs[i], debug_info(*this));
+        auto elem_type = expr->type->as<RefType>()->pointee;
+        auto value = make_struct(emitter, soa_elem_type(emitter, call_expr->callee->type), fields, debug_info(*this));
+        return emitter.down_cast(value, elem_type, type, debug_info(*this));
+    }
+    if (auto var = emitter.ssa_var(*expr))
+        return emitter.down_cast(emitter.state.vars[var], expr->type->as<RefType>()->pointee, type, debug_info(*this));
     return emitter.down_cast(emitter.emit(*expr), expr->type, type, debug_info(*this));
 }
 
@@ -1217,8 +2084,27 @@ const thorin::Def* StaticDecl::emit(Emitter& emitter) const {
     return emitter.world.global(value, is_mut, debug_info(*this));
 }
 
+/// Returns true if the given type variable only appears in the given type
+/// through tuples and function types, which means that a polymorphic function
+/// with that signature can only pass values of that type through.
+static bool is_passed_through(const artic::Type* type, const artic::TypeVar* var) {
+    if (type == var || !type->contains(var))
+        return true;
+    if (auto tuple_type = type->isa<artic::TupleType>()) {
+        return std::all_of(tuple_type->args.begin(), tuple_type->args.end(), [var] (auto arg) {
+            return is_passed_through(arg, var);
+        });
+    }
+    if (auto fn_type = type->isa<artic::FnType>())
+        return is_passed_through(fn_type->dom, var) && is_passed_through(fn_type->codom, var);
+    return false;
+}
+
 const thorin::Def* FnDecl::emit(Emitter& emitter) const {
     auto _ = emitter.save_state();
+    // Nested functions inherit the fast-math flags of the enclosing function or block
+    if (auto flags = fast_math_flags(attrs.get()); !flags.empty() || is_top_level)
+        emitter.state.fast_math = flags;
     const thorin::FnType* cont_type = nullptr;
     Emitter::MonoFn mono_fn { this, {} };
     if (type_params) {
@@ -1227,6 +2113,32 @@ const thorin::Def* FnDecl::emit(Emitter& emitter) const {
         // Try to find an existing monomorphized version of this function with that type
         if (auto it = emitter.mono_fns.find(mono_fn); it != emitter.mono_fns.end())
             return it->second;
+        // Pointers that are only passed through do not change the generated code:
+        // Replace them by a canonical pointer type and cast the shared instance.
+        if (emitter.share_ptr_instances) {
+            auto body_type = type->as<artic::ForallType>()->body;
+            auto& type_table = type->type_table;
+            std::unordered_map<const artic::TypeVar*, const artic::Type*> map;
+            bool is_shared = false;
+            for (size_t i = 0, n = type_params->params.size(); i < n; ++i) {
+                auto var = type_params->params[i]->type->as<artic::TypeVar>();
+                auto type_arg = mono_fn.type_args[i];
+                if (auto ptr_type = type_arg->isa<artic::PtrType>(); ptr_type && is_passed_through(body_type, var)) {
+                    type_arg = type_table.ptr_type(type_table.prim_type(PrimType::U8), ptr_type->is_mut, ptr_type->addr_space);
+                    is_shared |= type_arg != mono_fn.type_args[i];
+                }
+                map.emplace(var, type_arg);
+            }
+            if (is_shared) {
+                map.insert(emitter.type_vars.begin(), emitter.type_vars.end());
+                std::swap(map, emitter.type_vars);
+                auto shared_type = body_type->replace(emitter.type_vars);
+                auto shared_cont = emit(emitter);
+                std::swap(map, emitter.type_vars);
+                auto cont = emitter.layout_cast(shared_cont, shared_type, body_type->replace(emitter.type_vars), debug_info(*this));
+                return emitter.mono_fns.emplace(std::move(mono_fn), cont->as_continuation()).first->second;
+            }
+        }
         emitter.poly_defs.emplace_back();
         cont_type = type->as<artic::ForallType>()->body->convert(emitter)->as<thorin::FnType>();
     } else {
@@ -1241,7 +2153,9 @@ const thorin::Def* FnDecl::emit(Emitter& emitter) const {
 
     // Set the calling convention and export the continuation if needed
     if (attrs) {
-        if (auto export_attr = attrs->find("export")) {
+        // Exported polymorphic functions are only made external
+        // for their explicit instantiations (see `ModDecl::emit`).
+        if (auto export_attr = attrs->find("export"); export_attr && !type_params) {
             cont->make_external();
             if (auto name_attr = export_attr->find("name"))
                 cont->debug().set(name_attr->as<LiteralAttr>()->lit.as_string());
@@ -1262,17 +2176,92 @@ const thorin::Def* FnDecl::emit(Emitter& emitter) const {
         }
     }
 
+    auto fn_type = (type_params ? type->as<artic::ForallType>()->body : type)->as<artic::FnType>();
+    auto dom = fn_type->dom->replace(emitter.type_vars);
+    auto param_types = dom->isa<artic::TupleType>()
+        ? dom->as<artic::TupleType>()->args
+        : std::vector<const artic::Type*> { dom };
+
+    // Large aggregates are passed by reference to the body of internal functions.
+    // The continuation with the original signature becomes a wrapper that is
+    // inlined at call sites, so that callers pass pointers to their values.
+    std::vector<bool> by_ref(param_types.size());
+    auto body_cont = cont;
+    if (fn->body && !fn->filter && !cont->is_external()) {
+        thorin::Array<const thorin::Type*> types(cont_type->num_ops());
+        for (size_t i = 0, n = cont_type->num_ops(); i < n; ++i)
+            types[i] = cont_type->op(i);
+        for (size_t i = 0; i < param_types.size(); ++i) {
+            if ((by_ref[i] = is_passed_by_ref(emitter, param_types[i])))
+                types[i + 1] = emitter.world.ptr_type(types[i + 1]);
+        }
+        if (std::find(by_ref.begin(), by_ref.end(), true) != by_ref.end())
+            body_cont = emitter.world.continuation(emitter.world.fn_type(types), debug_info(*this));
+    }
+
+    // Optimization attributes are forwarded to the generated LLVM function
+    if (attrs) {
+        static const std::pair<std::string_view, const char*> llvm_attrs[] = {
+            { "inline",   "alwaysinline" },
+            { "noinline", "noinline" },
+            { "cold",     "cold" },
+            { "hot",      "hot" },
+            { "pure",     "readnone" },
+            { "readonly", "readonly" }
+        };
+        for (auto& [name, llvm_attr] : llvm_attrs) {
+            if (attrs->find(name))
+                emitter.hints.fn_attrs[body_cont].push_back(llvm_attr);
+        }
+    }
+
+    // Mark `noalias` pointer parameters in the generated LLVM function, where
+    // parameters of unit or function type do not appear in the parameter list.
+    // Aggregates passed by reference point to a private copy that is never written to.
+    for (size_t i = 0, j = 0; i < param_types.size(); ++i) {
+        if (auto ptr_type = param_types[i]->isa<artic::PtrType>(); ptr_type && ptr_type->is_noalias)
+            emitter.hints.param_attrs[body_cont].emplace_back(j, "noalias");
+        if (by_ref[i]) {
+            emitter.hints.param_attrs[body_cont].emplace_back(j, "noalias");
+            emitter.hints.param_attrs[body_cont].emplace_back(j, "readonly");
+        }
+        if (!is_unit_type(param_types[i]) && !param_types[i]->isa<artic::FnType>())
+            j++;
+    }
+
     if (fn->body) {
         // Set the IR node before entering the body, in case
         // we encounter `return` or a recursive call.
-        fn->def = def = cont;
+        def = cont;
+        fn->def = body_cont;
+        emitter.ast_defs.push_back(&fn->def);
+
+        if (body_cont != cont) {
+            emitter.enter(cont);
+            thorin::Array<const thorin::Def*> args(cont->num_params());
+            for (size_t i = 0; i < param_types.size(); ++i)
+                args[i + 1] = by_ref[i] ? emitter.addr_of(cont->param(i + 1)) : cont->param(i + 1);
+            args[0] = emitter.state.mem;
+            args.back() = cont->params().back();
+            cont->jump(body_cont, args, debug_info(*this));
+            cont->set_all_true_filter();
+        }
 
-        emitter.enter(cont);
-        emitter.emit(*fn->param, emitter.tuple_from_params(cont, true));
+        emitter.enter(body_cont);
+        auto param = emitter.tuple_from_params(body_cont, true);
+        if (body_cont != cont) {
+            // The body works on a copy of the aggregates, which LLVM
+            // removes when the corresponding parameter is never modified
+            thorin::Array<const thorin::Def*> ops(param_types.size());
+            for (size_t i = 0; i < param_types.size(); ++i)
+                ops[i] = by_ref[i] ? emitter.load(body_cont->param(i + 1)) : body_cont->param(i + 1);
+            param = ops.size() == 1 ? ops[0] : emitter.world.tuple(ops);
+        }
+        emitter.emit(*fn->param, param);
         if (fn->filter)
             cont->set_filter(thorin::Array<const thorin::Def*>(cont->num_params(), emitter.emit(*fn->filter)));
         auto value = emitter.emit(*fn->body);
-        emitter.jump(cont->params().back(), value, debug_info(*fn->body));
+        emitter.jump(body_cont->params().back(), value, debug_info(*fn->body));
     }
 
     // Clear the thorin IR generated for this entire function
@@ -1299,10 +2288,65 @@ const thorin::Def* TypeDecl::emit(Emitter&) const {
     return nullptr;
 }
 
+/// Mangles a type so that it can be used as part of a symbol name.
+static std::string mangle(const artic::Type* type) {
+    std::ostringstream os;
+    log::Output out(os, false);
+    out << *type;
+    std::string name;
+    for (auto c : os.str()) {
+        if (std::isalnum(c))
+            name += c;
+        else if (c == '&')
+            name += 'p';
+        else if (!name.empty() && name.back() != '_')
+            name += '_';
+    }
+    while (!name.empty() && name.back() == '_')
+        name.pop_back();
+    return name;
+}
+
+static void emit_instances(Emitter& emitter, const FnDecl& fn_decl) {
+    auto prefix = fn_decl.id.name;
+    if (auto name_attr = fn_decl.attrs->find("export")->find("name"))
+        prefix = name_attr->as<LiteralAttr>()->lit.as_string();
+    for (auto& attr : fn_decl.attrs->args) {
+        if (attr->name != "instantiate")
+            continue;
+        std::unordered_map<const artic::TypeVar*, const artic::Type*> map;
+        auto name = prefix;
+        for (auto& param : fn_decl.type_params->params) {
+            auto arg = attr->find(param->id.name);
+            auto type = arg->isa<TypeAttr>()
+                ? arg->as<TypeAttr>()->type->type
+                : arg->as<PathAttr>()->path.type;
+            map.emplace(param->type->as<artic::TypeVar>(), type);
+            name += "_" + mangle(type);
+        }
+        if (auto name_attr = attr->find("name"))
+            name = name_attr->as<LiteralAttr>()->lit.as_string();
+
+        std::swap(map, emitter.type_vars);
+        auto cont = emitter.emit(fn_decl)->as_continuation();
+        fn_decl.def = nullptr;
+        std::swap(map, emitter.type_vars);
+        emitter.mono_locs.emplace(cont, attr->loc);
+        cont->make_external();
+        cont->debug().set(name);
+    }
+}
+
 const thorin::Def* ModDecl::emit(Emitter& emitter) const {
     for (auto& decl : decls) {
-        // Do not emit function declarations that are polymorphic
-        if (auto fn_decl = decl->isa<FnDecl>(); fn_decl && fn_decl->type_params)
+        // Polymorphic functions are only emitted when explicitly instantiated
+        if (auto fn_decl = decl->isa<FnDecl>(); fn_decl && fn_decl->type_params) {
+            if (fn_decl->attrs && fn_decl->attrs->find("export"))
+                emit_instances(emitter, *fn_decl);
+            continue;
+        }
+        // Declarations that are used by exported functions are emitted on demand
+        if (emitter.only_reachable && !decl->isa<ModDecl>() && !(decl->attrs && decl->attrs->find("export")))
             continue;
         emitter.emit(*decl);
     }
@@ -1332,9 +2376,10 @@ void FieldPtrn::emit(Emitter& emitter, const thorin::Def* value) const {
 }
 
 void StructPtrn::emit(Emitter& emitter, const thorin::Def* value) const {
+    auto [_, struct_type] = match_app<artic::StructType>(type);
     for (auto& field : fields) {
         if (!field->is_etc())
-            emitter.emit(*field, emitter.world.extract(value, field->index));
+            emitter.emit(*field, emitter.world.extract(value, field_index(struct_type->decl, field->index)));
     }
 }
 
@@ -1384,6 +2429,19 @@ const thorin::Type* TupleType::convert(Emitter& emitter) const {
 const thorin::Type* SizedArrayType::convert(Emitter& emitter) const {
     if (is_simd)
         return emitter.world.type(elem->convert(emitter)->as<thorin::PrimType>()->primtype_tag(), size);
+    if (auto mono_type = replace(emitter.type_vars); is_soa_type(mono_type->as<SizedArrayType>()->elem)) {
+        // Arrays of `#[soa]` structures are stored as a structure of arrays, one per field
+        if (auto it = emitter.types.find(mono_type); it != emitter.types.end())
+            return it->second;
+        auto [type_app, struct_type] = match_app<artic::StructType>(mono_type->as<SizedArrayType>()->elem);
+        auto type = emitter.world.struct_type(struct_type->decl.id.name + "_soa", struct_type->member_count());
+        emitter.types[mono_type] = type;
+        for (size_t i = 0, n = struct_type->member_count(); i < n; ++i) {
+            auto member_type = type_app ? type_app->member_type(i) : struct_type->member_type(i);
+            type->set(i, emitter.world.definite_array_type(member_type->convert(emitter), size));
+        }
+        return type;
+    }
     return emitter.world.definite_array_type(elem->convert(emitter), size);
 }
 
@@ -1411,27 +2469,59 @@ const thorin::Type* TypeVar::convert(Emitter& emitter) const {
 const thorin::Type* StructType::convert(Emitter& emitter, const Type* parent) const {
     if (auto it = emitter.types.find(this); !decl.type_params && it != emitter.types.end())
         return it->second;
-    auto type = emitter.world.struct_type(decl.id.name, decl.fields.size());
+    // Thorin structures have no alignment or padding control. An empty array of
+    // byte vectors of size N has an alignment of N but occupies no space: It is
+    // inserted before fields marked with `#[align = N]`, and at the end of
+    // structures marked with `#[align = N]`, which also pads their size.
+    // Markers are only valid in LLVM IR (see `Emitter::check_device_code`).
+    auto align_marker = [&] (const ast::NamedDecl& aligned_decl, size_t align) {
+        emitter.align_locs.emplace(align, aligned_decl.loc);
+        return emitter.world.definite_array_type(emitter.world.type_pu8(align), 0);
+    };
+    auto struct_align = decl_align(decl);
+    auto num_fields = decl.fields.empty() ? 0 : field_index(decl, decl.fields.size() - 1) + 1;
+    auto type = emitter.world.struct_type(decl.id.name, num_fields + (struct_align != 0 ? 1 : 0));
     emitter.types[parent] = type;
-    for (size_t i = 0, n = decl.fields.size(); i < n; ++i)
-        type->set(i, decl.fields[i]->ast::Node::type->convert(emitter));
+    for (size_t i = 0, n = decl.fields.size(); i < n; ++i) {
+        if (auto align = decl_align(*decl.fields[i]))
+            type->set(field_index(decl, i) - 1, align_marker(*decl.fields[i], align));
+        type->set(field_index(decl, i), decl.fields[i]->ast::Node::type->convert(emitter));
+    }
+    if (struct_align != 0)
+        type->set(num_fields, align_marker(decl, struct_align));
     return type;
 }
 
 const thorin::Type* EnumType::convert(Emitter& emitter, const Type* parent) const {
     if (auto it = emitter.types.find(this); !decl.type_params && it != emitter.types.end())
         return it->second;
+    auto index_type =
+        decl.options.size() < (size_t(1) << 8)  ? emitter.world.type_pu8()  :
+        decl.options.size() < (size_t(1) << 16) ? emitter.world.type_pu16() :
+        decl.options.size() < (size_t(1) << 32) ? emitter.world.type_pu32() :
+        emitter.world.type_pu64();
+    // Enumerations without payloads are represented by their tag, and those
+    // with a single pointer payload by that pointer, null being the other option.
+    switch (enum_layout(emitter, parent)) {
+        case EnumLayout::Tag:
+            return emitter.types[parent] = index_type;
+        case EnumLayout::NullablePtr: {
+            // The payload is found in the members of the instance, as in `enum_layout()`,
+            // since the option types of the declaration may be type variables.
+            auto type_app = parent->isa<TypeApp>();
+            auto option_type = [&] (size_t i) { return type_app ? type_app->member_type(i) : member_type(i); };
+            size_t payload_index = is_unit_type(option_type(0)) ? 1 : 0;
+            return emitter.types[parent] = option_type(payload_index)->convert(emitter);
+        }
+        default:
+            break;
+    }
     auto type = emitter.world.struct_type(decl.id.name, 2);
     emitter.types[parent] = type;
     thorin::TypeSet types;
     for (size_t i = 0, n = decl.options.size(); i < n; ++i)
         types.insert(decl.options[i]->type->convert(emitter));
     thorin::Array<const thorin::Type*> ops(types.begin(), types.end());
-    auto index_type =
-        decl.options.size() < (size_t(1) << 8)  ? emitter.world.type_pu8()  :
-        decl.options.size() < (size_t(1) << 16) ? emitter.world.type_pu16() :
-        decl.options.size() < (size_t(1) << 32) ? emitter.world.type_pu32() :
-        emitter.world.type_pu64();
     type->set(0, index_type);
     type->set(1, emitter.world.variant_type(ops));
     return type;
@@ -0,0 +1,252 @@
+#include "artic/hints.h"
+
+#include <thorin/world.h>
+
+#include <llvm/ADT/StringSwitch.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Operator.h>
+
+namespace artic {
+
+using LoopMD = std::vector<std::pair<std::string, std::optional<unsigned>>>;
+
+/// Returns the name of the LLVM function generated for the given continuation.
+static std::string llvm_name(const thorin::Continuation* cont) {
+    return cont->is_external() || cont->empty() ? cont->name() : cont->unique_name();
+}
+
+static void add_fn_attrs(llvm::Function& fn, const std::vector<std::string>& attrs) {
+    for (auto& attr : attrs) {
+        // Memory effects are not plain attributes in recent versions of LLVM
+        if (attr == "readnone")
+            fn.setDoesNotAccessMemory();
+        else if (attr == "readonly")
+            fn.setOnlyReadsMemory();
+        else if (auto kind = llvm::Attribute::getAttrKindFromName(attr); kind != llvm::Attribute::None)
+            fn.addFnAttr(kind);
+    }
+}
+
+static void add_param_attrs(llvm::Function& fn, const std::vector<std::pair<size_t, std::string>>& attrs) {
+    for (auto& [index, attr] : attrs) {
+        // Parameters may have been removed by the optimizer, and attributes only apply to pointers
+        if (index >= fn.arg_size() || !fn.getArg(index)->getType()->isPointerTy())
+            continue;
+        if (auto kind = llvm::Attribute::getAttrKindFromName(attr); kind != llvm::Attribute::None)
+            fn.addParamAttr(index, kind);
+    }
+}
+
+static llvm::MDNode* loop_id(llvm::LLVMContext& context, const LoopMD& md) {
+    // Loop identifiers are distinct nodes that refer to themselves in their first operand
+    std::vector<llvm::Metadata*> ops { nullptr };
+    for (auto& [name, value] : md) {
+        std::vector<llvm::Metadata*> hint { llvm::MDString::get(context, name) };
+        if (value) {
+            auto type = name.size() > 7 && name.compare(name.size() - 7, 7, ".enable") == 0
+                ? llvm::Type::getInt1Ty(context)
+                : llvm::Type::getInt32Ty(context);
+            hint.push_back(llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(type, *value)));
+        }
+        ops.push_back(llvm::MDNode::get(context, hint));
+    }
+    auto id = llvm::MDNode::getDistinct(context, ops);
+    id->replaceOperandWith(0, id);
+    return id;
+}
+
+static void add_loop_md(
+    llvm::Function& fn,
+    const std::unordered_map<std::string, const LoopMD*>& md_by_label)
+{
+    if (fn.isDeclaration())
+        return;
+    std::unique_ptr<llvm::LoopInfo> loop_info;
+    std::unique_ptr<llvm::DominatorTree> dom_tree;
+    for (auto& block : fn) {
+        auto it = md_by_label.find(block.getName().str());
+        if (it == md_by_label.end())
+            continue;
+        if (!loop_info) {
+            dom_tree = std::make_unique<llvm::DominatorTree>(fn);
+            loop_info = std::make_unique<llvm::LoopInfo>(*dom_tree);
+        }
+        // The block is either the loop header, or a block in the body of the loop.
+        // Loops that already have metadata belong to another continuation.
+        auto loop = loop_info->getLoopFor(&block);
+        if (loop && !loop->getLoopID())
+            loop->setLoopID(loop_id(fn.getContext(), *it->second));
+    }
+}
+
+static llvm::FastMathFlags to_fast_math_flags(const std::vector<std::string>& names) {
+    llvm::FastMathFlags flags;
+    for (auto& name : names) {
+        if (name == "fast")     flags.setFast();
+        if (name == "nnan")     flags.setNoNaNs();
+        if (name == "ninf")     flags.setNoInfs();
+        if (name == "nsz")      flags.setNoSignedZeros();
+        if (name == "arcp")     flags.setAllowReciprocal();
+        if (name == "contract") flags.setAllowContract(true);
+        if (name == "afn")      flags.setApproxFunc();
+        if (name == "reassoc")  flags.setAllowReassoc();
+    }
+    return flags;
+}
+
+/// Returns the predicate of a floating-point comparison (e.g. `fcmp_olt`), or `BAD_FCMP_PREDICATE`.
+static llvm::CmpInst::Predicate fcmp_predicate(llvm::StringRef op) {
+    return llvm::StringSwitch<llvm::CmpInst::Predicate>(op)
+        .Case("fcmp_oeq", llvm::CmpInst::FCMP_OEQ)
+        .Case("fcmp_une", llvm::CmpInst::FCMP_UNE)
+        .Case("fcmp_ogt", llvm::CmpInst::FCMP_OGT)
+        .Case("fcmp_olt", llvm::CmpInst::FCMP_OLT)
+        .Case("fcmp_oge", llvm::CmpInst::FCMP_OGE)
+        .Case("fcmp_ole", llvm::CmpInst::FCMP_OLE)
+        .Default(llvm::CmpInst::BAD_FCMP_PREDICATE);
+}
+
+/// Replaces a call to a placeholder function by the operation it stands for (see `fast_math_prefix`).
+static void lower_fast_math_op(llvm::CallInst& call, llvm::StringRef op, llvm::FastMathFlags flags) {
+    llvm::IRBuilder<> builder(&call);
+    builder.setFastMathFlags(flags);
+    auto a = call.getArgOperand(0);
+    auto b = call.arg_size() > 1 ? call.getArgOperand(1) : nullptr;
+    llvm::Value* value = nullptr;
+    if      (op == "fneg") value = builder.CreateFNeg(a);
+    else if (op == "fadd") value = builder.CreateFAdd(a, b);
+    else if (op == "fsub") value = builder.CreateFSub(a, b);
+    else if (op == "fmul") value = builder.CreateFMul(a, b);
+    else if (op == "fdiv") value = builder.CreateFDiv(a, b);
+    else if (op == "frem") value = builder.CreateFRem(a, b);
+    else                   value = builder.CreateFCmp(fcmp_predicate(op), a, b);
+    call.replaceAllUsesWith(value);
+    call.eraseFromParent();
+}
+
+/// Returns the placeholder functions declared in the module with the given prefix, along with the rest of their name.
+static std::vector<std::pair<llvm::Function*, llvm::StringRef>> placeholders(llvm::Module& module, const char* prefix) {
+    std::vector<std::pair<llvm::Function*, llvm::StringRef>> fns;
+    for (auto& fn : module) {
+        if (auto name = fn.getName(); fn.isDeclaration() && name.consume_front(prefix))
+            fns.emplace_back(&fn, name);
+    }
+    return fns;
+}
+
+static void lower_fast_math_ops(llvm::Module& module) {
+    for (auto [fn, name] : placeholders(module, LLVMHints::fast_math_prefix)) {
+        // The name is made of the operation, the flags, and the type of the operands
+        llvm::SmallVector<llvm::StringRef, 8> parts;
+        name.split(parts, '.');
+        std::vector<std::string> flags;
+        for (size_t i = 1; i + 1 < parts.size(); ++i)
+            flags.push_back(parts[i].str());
+        while (!fn->use_empty())
+            lower_fast_math_op(*llvm::cast<llvm::CallInst>(fn->user_back()), parts.front(), to_fast_math_flags(flags));
+        fn->eraseFromParent();
+    }
+}
+
+static void lower_nontemporal_ops(llvm::Module& module) {
+    for (auto [fn, name] : placeholders(module, LLVMHints::nontemporal_prefix)) {
+        auto is_load = name.consume_front("load.");
+        while (!fn->use_empty()) {
+            auto call = llvm::cast<llvm::CallInst>(fn->user_back());
+            llvm::IRBuilder<> builder(call);
+            auto ptr = call->getArgOperand(0);
+            llvm::Instruction* inst = nullptr;
+            if (is_load) {
+                inst = builder.CreateLoad(call->getType(), ptr);
+                call->replaceAllUsesWith(inst);
+            } else
+                inst = builder.CreateStore(call->getArgOperand(1), ptr);
+            // The operand of `!nontemporal` must be the integer 1
+            auto one = llvm::ConstantAsMetadata::get(builder.getInt32(1));
+            inst->setMetadata(llvm::LLVMContext::MD_nontemporal, llvm::MDNode::get(module.getContext(), one));
+            call->eraseFromParent();
+        }
+        fn->eraseFromParent();
+    }
+}
+
+static void lower_prefetches(llvm::Module& module) {
+    for (auto [fn, name] : placeholders(module, LLVMHints::prefetch_prefix)) {
+        while (!fn->use_empty()) {
+            auto call = llvm::cast<llvm::CallInst>(fn->user_back());
+            llvm::IRBuilder<> builder(call);
+            auto ptr = call->getArgOperand(0);
+            auto intrinsic = llvm::Intrinsic::getDeclaration(&module, llvm::Intrinsic::prefetch, { ptr->getType() });
+            builder.CreateCall(intrinsic, {
+                ptr,
+                call->getArgOperand(1),
+                call->getArgOperand(2),
+                builder.getInt32(1) // Data cache
+            });
+            call->eraseFromParent();
+        }
+        fn->eraseFromParent();
+    }
+}
+
+static void add_fast_math(llvm::Function& fn, llvm::FastMathFlags module_flags) {
+    if (module_flags.none())
+        return;
+    for (auto& inst : llvm::instructions(fn)) {
+        if (!llvm::isa<llvm::FPMathOperator>(inst))
+            continue;
+        auto flags = module_flags;
+        flags |= inst.getFastMathFlags();
+        inst.setFastMathFlags(flags);
+    }
+}
+
+static void set_target(llvm::Function& fn, const std::string& cpu, const std::string& features) {
+    // Only definitions are compiled for the target
+    if (fn.isDeclaration())
+        return;
+    if (!cpu.empty())
+        fn.addFnAttr("target-cpu", cpu);
+    if (!features.empty())
+        fn.addFnAttr("target-features", features);
+}
+
+void LLVMHints::apply(thorin::World& world, llvm::Module& module) const {
+    // Only look at the continuations that are still alive
+    std::unordered_map<std::string, const std::vector<std::string>*> attrs_by_name;
+    std::unordered_map<std::string, const std::vector<std::pair<size_t, std::string>>*> param_attrs_by_name;
+    std::unordered_map<std::string, const LoopMD*> md_by_label;
+    for (auto cont : world.copy_continuations()) {
+        if (auto it = fn_attrs.find(cont); it != fn_attrs.end())
+            attrs_by_name.emplace(llvm_name(cont), &it->second);
+        if (auto it = param_attrs.find(cont); it != param_attrs.end())
+            param_attrs_by_name.emplace(llvm_name(cont), &it->second);
+        if (auto it = loop_md.find(cont); it != loop_md.end())
+            md_by_label.emplace(cont->unique_name(), &it->second);
+    }
+
+    lower_fast_math_ops(module);
+    lower_nontemporal_ops(module);
+    lower_prefetches(module);
+    auto module_flags = to_fast_math_flags(fast_math);
+    for (auto& fn : module) {
+        if (auto it = attrs_by_name.find(fn.getName().str()); it != attrs_by_name.end())
+            add_fn_attrs(fn, *it->second);
+        if (auto it = param_attrs_by_name.find(fn.getName().str()); it != param_attrs_by_name.end())
+            add_param_attrs(fn, *it->second);
+        if (!md_by_label.empty())
+            add_loop_md(fn, md_by_label);
+        add_fast_math(fn, module_flags);
+        set_target(fn, target_cpu, target_features);
+    }
+}
+
+} // namespace artic
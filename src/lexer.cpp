@@ -27,6 +27,7 @@ std::unordered_map<std::string, Token::Tag> Lexer::keywords{
     std::make_pair("mod",       Token::Mod),
     std::make_pair("asm",       Token::Asm),
     std::make_pair("addrspace", Token::AddrSpace),
+    std::make_pair("noalias",   Token::NoAlias),
     std::make_pair("simd",      Token::Simd)
 };
 
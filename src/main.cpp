@@ -3,6 +3,9 @@
 #include <streambuf>
 #include <istream>
 #include <fstream>
+#include <sstream>
+#include <optional>
+#include <tuple>
 
 #include "artic/log.h"
 #include "artic/locator.h"
@@ -12,11 +15,46 @@
 #include "artic/bind.h"
 #include "artic/check.h"
 #include "artic/emit.h"
+#include "artic/cache.h"
+#include "artic/module.h"
+
+#include "build_id.h"
 
 #include <thorin/world.h>
 #include <thorin/util/log.h>
 #ifdef ENABLE_LLVM
 #include <thorin/be/llvm/llvm.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#if LLVM_VERSION_MAJOR >= 14
+#include <llvm/MC/TargetRegistry.h>
+#else
+#include <llvm/Support/TargetRegistry.h>
+#endif
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define ENABLE_DAEMON
+#include <csignal>
+#include <filesystem>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #endif
 
 using namespace artic;
@@ -42,9 +80,31 @@ static void usage() {
                 "         --max-errors <n>       Sets the maximum number of error messages (unlimited by default)\n"
                 "         --print-ast            Prints the AST after parsing and type-checking\n"
                 "         --emit-thorin          Prints the Thorin IR after code generation\n"
+                "         --emit-module          Emits the parsed declarations of the input files as a module (.artm)\n"
+                "         --module <file>        Loads the declarations of a module before the input files (only lexing and parsing are skipped)\n"
+                "         --only-reachable       Only emits declarations that are reachable from exported functions\n"
+                "         --lazy-parsing         Only parses the bodies of top-level functions that are used or exported (others are not checked)\n"
+                "         --share-ptr-instances  Shares the code of polymorphic functions instantiated with different pointer types\n"
+                "         --mono-report          Prints the instances of every polymorphic function, sorted by size\n"
+                "         --by-ref-threshold <n> Passes structures, tuples, and arrays of n bytes or more by reference (0 disables, defaults to 64)\n"
                 "         --log-level <lvl>      Changes the log level in Thorin (lvl = debug, verbose, info, warn, or error, defaults to error)\n"
 #ifdef ENABLE_LLVM
                 "         --emit-llvm            Emits LLVM IR in the output file\n"
+                "         --emit-bc              Emits LLVM bitcode in the output file\n"
+                "         --emit-obj             Emits a native object file in the output file\n"
+                "         --target <triple>      Sets the target triple of the generated code (defaults to the host, must have the same data layout)\n"
+                "         --cpu <name>           Sets the target CPU of the generated code (e.g. skylake-avx512, or native for the host)\n"
+                "         --features <list>      Enables or disables target features (e.g. +avx2,+fma,-avx512f)\n"
+                "         --run                  Compiles the host code in memory and runs its 'main' function with the arguments after '--'\n"
+                "         --load <lib>           Loads a shared library to resolve imported functions with --run\n"
+                "         --fast-math            Enables all fast-math optimizations on floating-point operations\n"
+                "         --fast-math-flags <f>  Enables some fast-math optimizations (f = comma-separated list of nnan, ninf, nsz, arcp, contract, afn, or reassoc)\n"
+                "         --library <file>       Compiles the given file before the input files, and lets the compiler server keep it in memory\n"
+                "         --daemon <socket>      Starts a compiler server listening on the given Unix socket\n"
+                "         --connect <socket>     Sends the compilation to the compiler server listening on the given socket\n"
+                "         --cache-dir <dir>      Restores the emitted files from the given cache directory, or stores them there\n"
+                "         --cache-size <n>       Sets the maximum size of the cache in MiB (defaults to 1024)\n"
+                "         --cache-stats          Prints the number of cache hits and misses, and the size of the cache\n"
                 "  -g     --debug                Enable debug information in the generated LLVM IR file\n"
 #endif
                 "  -On                           Sets the optimization level (n = 0, 1, 2, or 3, defaults to 0)\n"
@@ -81,6 +141,8 @@ static void version() {
 
 struct ProgramOptions {
     std::vector<std::string> files;
+    std::vector<std::string> libraries;
+    std::vector<std::string> modules;
     std::string module_name;
     bool exit = false;
     bool no_color = false;
@@ -89,7 +151,27 @@ struct ProgramOptions {
     bool debug = false;
     bool print_ast = false;
     bool emit_thorin = false;
+    bool emit_module = false;
+    bool only_reachable = false;
+    bool lazy_parsing = false;
+    bool share_ptr_instances = false;
+    bool mono_report = false;
+    std::optional<size_t> by_ref_threshold;
     bool emit_llvm = false;
+    bool emit_bc = false;
+    bool emit_obj = false;
+    std::string target_triple;
+    std::string target_cpu;
+    std::string target_features;
+    std::vector<std::string> fast_math;
+    bool run = false;
+    std::vector<std::string> libs;
+    std::vector<std::string> run_args;
+    std::string cache_dir;
+    std::optional<size_t> cache_size;
+    bool cache_stats = false;
+    std::string daemon_socket;
+    std::string connect_socket;
     unsigned opt_level = 0;
     size_t max_errors = 0;
     thorin::Log::Level log_level = thorin::Log::Error;
@@ -166,6 +248,34 @@ struct ProgramOptions {
                     if (!check_dup(argv[i], emit_thorin))
                         return false;
                     emit_thorin = true;
+                } else if (matches(argv[i], "--emit-module")) {
+                    if (!check_dup(argv[i], emit_module))
+                        return false;
+                    emit_module = true;
+                } else if (matches(argv[i], "--module")) {
+                    if (!check_arg(argc, argv, i))
+                        return false;
+                    modules.push_back(argv[++i]);
+                } else if (matches(argv[i], "--only-reachable")) {
+                    if (!check_dup(argv[i], only_reachable))
+                        return false;
+                    only_reachable = true;
+                } else if (matches(argv[i], "--lazy-parsing")) {
+                    if (!check_dup(argv[i], lazy_parsing))
+                        return false;
+                    lazy_parsing = true;
+                } else if (matches(argv[i], "--share-ptr-instances")) {
+                    if (!check_dup(argv[i], share_ptr_instances))
+                        return false;
+                    share_ptr_instances = true;
+                } else if (matches(argv[i], "--mono-report")) {
+                    if (!check_dup(argv[i], mono_report))
+                        return false;
+                    mono_report = true;
+                } else if (matches(argv[i], "--by-ref-threshold")) {
+                    if (!check_dup(argv[i], by_ref_threshold.has_value()) || !check_arg(argc, argv, i))
+                        return false;
+                    by_ref_threshold = std::strtoull(argv[++i], NULL, 10);
                 } else if (matches(argv[i], "--log-level")) {
                     if (!check_arg(argc, argv, i))
                         return false;
@@ -194,6 +304,105 @@ struct ProgramOptions {
                     log::error("Thorin is built without LLVM support");
                     return false;
 #endif
+                } else if (matches(argv[i], "--emit-bc")) {
+                    if (!check_dup(argv[i], emit_bc))
+                        return false;
+#ifdef ENABLE_LLVM
+                    emit_bc = true;
+#else
+                    log::error("Thorin is built without LLVM support");
+                    return false;
+#endif
+                } else if (matches(argv[i], "--emit-obj")) {
+                    if (!check_dup(argv[i], emit_obj))
+                        return false;
+#ifdef ENABLE_LLVM
+                    emit_obj = true;
+#else
+                    log::error("Thorin is built without LLVM support");
+                    return false;
+#endif
+                } else if (matches(argv[i], "--target")) {
+                    if (!check_dup(argv[i], !target_triple.empty()) || !check_arg(argc, argv, i))
+                        return false;
+                    target_triple = argv[++i];
+                } else if (matches(argv[i], "--cpu")) {
+                    if (!check_dup(argv[i], !target_cpu.empty()) || !check_arg(argc, argv, i))
+                        return false;
+                    target_cpu = argv[++i];
+                } else if (matches(argv[i], "--features")) {
+                    if (!check_dup(argv[i], !target_features.empty()) || !check_arg(argc, argv, i))
+                        return false;
+                    target_features = argv[++i];
+                } else if (matches(argv[i], "--run")) {
+                    if (!check_dup(argv[i], run))
+                        return false;
+#ifdef ENABLE_LLVM
+                    run = true;
+#else
+                    log::error("Thorin is built without LLVM support");
+                    return false;
+#endif
+                } else if (matches(argv[i], "--load")) {
+                    if (!check_arg(argc, argv, i))
+                        return false;
+                    libs.push_back(argv[++i]);
+                } else if (matches(argv[i], "--")) {
+                    // The remaining arguments are passed to the program run with `--run`
+                    run_args.assign(argv + i + 1, argv + argc);
+                    break;
+                } else if (matches(argv[i], "--fast-math")) {
+                    fast_math.push_back("fast");
+                } else if (matches(argv[i], "--fast-math-flags")) {
+                    if (!check_arg(argc, argv, i))
+                        return false;
+                    std::istringstream is(argv[++i]);
+                    for (std::string flag; std::getline(is, flag, ',');) {
+                        auto& flags = LLVMHints::fast_math_flags;
+                        if (std::find(std::begin(flags), std::end(flags), flag) == std::end(flags)) {
+                            log::error("unknown fast-math flag '{}'", flag);
+                            return false;
+                        }
+                        fast_math.push_back(flag);
+                    }
+                } else if (matches(argv[i], "--library")) {
+                    if (!check_arg(argc, argv, i))
+                        return false;
+                    libraries.push_back(argv[++i]);
+                } else if (matches(argv[i], "--daemon")) {
+                    if (!check_dup(argv[i], !daemon_socket.empty()) || !check_arg(argc, argv, i))
+                        return false;
+#ifdef ENABLE_DAEMON
+                    daemon_socket = argv[++i];
+#else
+                    log::error("the compiler server is not supported on this platform");
+                    return false;
+#endif
+                } else if (matches(argv[i], "--connect")) {
+                    if (!check_dup(argv[i], !connect_socket.empty()) || !check_arg(argc, argv, i))
+                        return false;
+#ifdef ENABLE_DAEMON
+                    connect_socket = argv[++i];
+#else
+                    log::error("the compiler server is not supported on this platform");
+                    return false;
+#endif
+                } else if (matches(argv[i], "--cache-dir")) {
+                    if (!check_dup(argv[i], !cache_dir.empty()) || !check_arg(argc, argv, i))
+                        return false;
+                    cache_dir = argv[++i];
+                } else if (matches(argv[i], "--cache-size")) {
+                    if (!check_dup(argv[i], cache_size.has_value()) || !check_arg(argc, argv, i))
+                        return false;
+                    cache_size = std::strtoull(argv[++i], NULL, 10);
+                    if (*cache_size == 0) {
+                        log::error("maximum size of the cache must be greater than 0");
+                        return false;
+                    }
+                } else if (matches(argv[i], "--cache-stats")) {
+                    if (!check_dup(argv[i], cache_stats))
+                        return false;
+                    cache_stats = true;
                 } else if (matches(argv[i], "-O0")) {
                     opt_level = 0;
                 } else if (matches(argv[i], "-O1")) {
@@ -263,24 +472,408 @@ static std::optional<std::string> read_file(const std::string& file) {
     }
 }
 
-static bool compile(const ProgramOptions& opts, Log& log) {
-    ast::ModDecl program;
+#ifdef ENABLE_LLVM
+/// Replaces the CPU name `native` with the name and features of the host CPU.
+/// Features given on the command line override the ones of the host.
+static void resolve_native_cpu(ProgramOptions& opts) {
+    opts.target_cpu = llvm::sys::getHostCPUName().str();
+    llvm::StringMap<bool> host_features;
+    if (llvm::sys::getHostCPUFeatures(host_features)) {
+        std::string features;
+        for (auto& feature : host_features)
+            features += (feature.second ? "+" : "-") + feature.first().str() + ",";
+        if (opts.target_features.empty() && !features.empty())
+            features.pop_back();
+        opts.target_features = features + opts.target_features;
+    }
+}
+
+/// Creates a target machine with the given triple, and the CPU and features given on the command line.
+static std::unique_ptr<llvm::TargetMachine> create_target_machine(const ProgramOptions& opts, const std::string& triple) {
+    std::string error;
+    auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (!target) {
+        log::error("cannot emit code for target '{}': {}", triple, error);
+        return nullptr;
+    }
+    static const llvm::CodeGenOpt::Level codegen_opt_levels[] = {
+        llvm::CodeGenOpt::None,
+        llvm::CodeGenOpt::Less,
+        llvm::CodeGenOpt::Default,
+        llvm::CodeGenOpt::Aggressive
+    };
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+        triple, opts.target_cpu.empty() ? "generic" : opts.target_cpu, opts.target_features,
+        llvm::TargetOptions(), llvm::Reloc::PIC_, llvm::None,
+        codegen_opt_levels[opts.opt_level]));
+}
+
+/// Selects the target of the host code, and returns the corresponding target machine. The module
+/// is generated for the host, with the sizes and alignments of its types already lowered: Other
+/// targets are only accepted when they have the same data layout as the host.
+static std::unique_ptr<llvm::TargetMachine> select_target(const ProgramOptions& opts, llvm::Module& module) {
+    auto host_triple = llvm::sys::getDefaultTargetTriple();
+    auto machine = create_target_machine(opts, opts.target_triple.empty() ? host_triple : opts.target_triple);
+    if (!machine)
+        return nullptr;
+    if (!opts.target_triple.empty()) {
+        auto host_machine = create_target_machine(opts, host_triple);
+        if (!host_machine)
+            return nullptr;
+        if (machine->createDataLayout() != host_machine->createDataLayout()) {
+            log::error("cannot emit code for target '{}', which has a different data layout than the host ('{}')",
+                opts.target_triple, host_triple);
+            return nullptr;
+        }
+    }
+    module.setTargetTriple(machine->getTargetTriple().str());
+    module.setDataLayout(machine->createDataLayout());
+    return machine;
+}
+
+/// Optimizes the host code with the standard LLVM pipeline for the optimization level given on the
+/// command line. This runs after the hints have been added, so that the optimizer can make use of them.
+static void optimize_llvm_module(const ProgramOptions& opts, llvm::TargetMachine& machine, llvm::Module& module) {
+#if LLVM_VERSION_MAJOR >= 14
+    using OptimizationLevel = llvm::OptimizationLevel;
+#else
+    using OptimizationLevel = llvm::PassBuilder::OptimizationLevel;
+#endif
+    llvm::LoopAnalysisManager loop_analyses;
+    llvm::FunctionAnalysisManager function_analyses;
+    llvm::CGSCCAnalysisManager cgscc_analyses;
+    llvm::ModuleAnalysisManager module_analyses;
+    llvm::PassBuilder builder(&machine);
+    builder.registerModuleAnalyses(module_analyses);
+    builder.registerCGSCCAnalyses(cgscc_analyses);
+    builder.registerFunctionAnalyses(function_analyses);
+    builder.registerLoopAnalyses(loop_analyses);
+    builder.crossRegisterProxies(loop_analyses, function_analyses, cgscc_analyses, module_analyses);
+
+    // Even without optimizations, functions marked with `inline` have to be inlined
+    static const OptimizationLevel opt_levels[] = {
+        OptimizationLevel::O0,
+        OptimizationLevel::O1,
+        OptimizationLevel::O2,
+        OptimizationLevel::O3
+    };
+    auto passes = opts.opt_level == 0
+        ? builder.buildO0DefaultPipeline(OptimizationLevel::O0)
+        : builder.buildPerModuleDefaultPipeline(opt_levels[opts.opt_level]);
+    passes.run(module, module_analyses);
+}
+
+/// Writes the host code as LLVM IR (.ll), LLVM bitcode (.bc), or as a native object file (.o).
+static bool emit_llvm_module(const ProgramOptions& opts, llvm::TargetMachine& machine, const llvm::Module& module, const std::string& ext) {
+    auto name = opts.module_name + ext;
+    std::error_code err;
+    llvm::raw_fd_ostream os(name, err, ext == ".ll" ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None);
+    if (err) {
+        log::error("cannot open '{}' for writing", name);
+        return false;
+    }
+    if (ext == ".ll") {
+        module.print(os, nullptr);
+    } else if (ext == ".bc") {
+        llvm::WriteBitcodeToFile(module, os);
+    } else {
+        // Code generation modifies the module, which may still be needed for other outputs
+        auto copy = llvm::CloneModule(module);
+        llvm::legacy::PassManager pass_manager;
+        if (machine.addPassesToEmitFile(pass_manager, os, nullptr, llvm::CGFT_ObjectFile)) {
+            log::error("cannot emit object files for target '{}'", machine.getTargetTriple().str());
+            return false;
+        }
+        pass_manager.run(*copy);
+    }
+
+    // Write errors (e.g. when the disk is full) are only known once the file is closed
+    os.close();
+    if (os.has_error()) {
+        log::error("cannot write '{}'", name);
+        os.clear_error();
+        return false;
+    }
+    return true;
+}
+
+/// Compiles the host code with the LLVM JIT, and runs its `main` function with the arguments
+/// given after `--`. Imported functions are searched for in the libraries given with `--load`,
+/// and then in the compiler process. Returns the exit code of the program.
+static std::optional<int> run_llvm_module(const ProgramOptions& opts, const llvm::Module& host_module) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    // The JIT owns the context of the modules it compiles, while the context of the host
+    // module belongs to the backend: The module is copied to a new context, through its bitcode.
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream bitcode_os(bitcode);
+    llvm::WriteBitcodeToFile(host_module, bitcode_os);
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), opts.module_name), *context);
+    if (!module) {
+        log::error("cannot copy module '{}': {}", opts.module_name, llvm::toString(module.takeError()));
+        return std::nullopt;
+    }
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+        log::error("cannot create JIT compiler: {}", llvm::toString(jit.takeError()));
+        return std::nullopt;
+    }
+    auto& dylib = (*jit)->getMainJITDylib();
+    auto prefix = (*jit)->getDataLayout().getGlobalPrefix();
+    for (auto& lib : opts.libs) {
+        auto generator = llvm::orc::DynamicLibrarySearchGenerator::Load(lib.c_str(), prefix);
+        if (!generator) {
+            log::error("cannot load library '{}': {}", lib, llvm::toString(generator.takeError()));
+            return std::nullopt;
+        }
+        dylib.addGenerator(std::move(*generator));
+    }
+    dylib.addGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix)));
+
+    (*module)->setDataLayout((*jit)->getDataLayout());
+    if (auto err = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(*module), std::move(context)))) {
+        log::error("cannot compile module '{}': {}", opts.module_name, llvm::toString(std::move(err)));
+        return std::nullopt;
+    }
+    auto main_symbol = (*jit)->lookup("main");
+    if (!main_symbol) {
+        log::error("cannot find exported function 'main': {}", llvm::toString(main_symbol.takeError()));
+        return std::nullopt;
+    }
+#if LLVM_VERSION_MAJOR >= 15
+    auto main_fn = main_symbol->toPtr<int (*)(int, char**)>();
+#else
+    auto main_fn = reinterpret_cast<int (*)(int, char**)>(main_symbol->getAddress());
+#endif
+
+    // The program gets a copy of its arguments, as it may modify them
+    std::vector<std::string> args { opts.module_name };
+    args.insert(args.end(), opts.run_args.begin(), opts.run_args.end());
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(arg.data());
+    argv.push_back(nullptr);
+    return main_fn(static_cast<int>(args.size()), argv.data());
+}
+#endif
+
+/// Returns the key under which the files emitted for the given options, contents of the
+/// input files, and modules are stored in the cache. The key contains all of these inputs,
+/// so that two compilations only share an entry if they are given the same inputs.
+static std::string cache_key(
+    const ProgramOptions& opts,
+    const std::vector<std::string>& files,
+    const std::vector<std::string_view>& contents,
+    const std::vector<std::string>& module_data)
+{
+    std::string key;
+    // Every input is prefixed by its size, so that the boundaries between inputs are not ambiguous
+    auto combine = [&] (const std::string_view& str) {
+        key += std::to_string(str.size());
+        key += ':';
+        key += str;
+    };
+    auto combine_int = [&] (size_t value) { combine(std::to_string(value)); };
+    // Entries stored by another build of the compiler are never used
+    combine_int(ARTIC_VERSION_MAJOR);
+    combine_int(ARTIC_VERSION_MINOR);
+    combine(ARTIC_BUILD_ID);
+    combine_int(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        combine(files[i]);
+        combine(contents[i]);
+    }
+    combine_int(opts.modules.size());
+    for (size_t i = 0; i < opts.modules.size(); ++i) {
+        combine(opts.modules[i]);
+        combine(module_data[i]);
+    }
+    combine(opts.module_name);
+    for (size_t value : {
+        size_t(opts.opt_level),
+        size_t(opts.debug),
+        size_t(opts.warns_as_errors),
+        size_t(opts.enable_all_warns),
+        size_t(opts.only_reachable),
+        size_t(opts.lazy_parsing),
+        size_t(opts.share_ptr_instances),
+        size_t(opts.by_ref_threshold.has_value()),
+        size_t(opts.by_ref_threshold.value_or(0)),
+        size_t(opts.emit_llvm),
+        size_t(opts.emit_bc),
+        size_t(opts.emit_obj)
+    })
+        combine_int(value);
+    combine(opts.target_triple);
+    combine(opts.target_cpu);
+    combine(opts.target_features);
+    combine_int(opts.fast_math.size());
+    for (auto& flag : opts.fast_math)
+        combine(flag);
+    return key;
+}
+
+static void print_cache_stats(const std::string& cache_dir) {
+    auto stats = Cache(cache_dir, 0).stats();
+    auto lookups = stats.hits + stats.misses;
+    log::out << "cache hits: " << stats.hits << "/" << lookups
+             << " (" << (lookups > 0 ? stats.hits * 100 / lookups : 0) << "%)\n"
+             << "cache size: " << stats.entries << " entries, " << (stats.size + 1023) / 1024 << " KiB\n";
+}
+
+/// Library files that have been parsed and type-checked on their own, which
+/// the compiler server keeps in memory to compile programs that use them.
+struct Library {
+    std::vector<std::string> contents;
+    PtrVector<ast::Decl> decls;
+    TypeTable type_table;
+};
+
+/// Parses and type-checks the given library files. Returns nothing if this produces any diagnostic
+/// other than the ones of the name binder, which is run again for every program that uses the library:
+/// Those diagnostics would otherwise be missing from the output of the compiler server.
+static std::unique_ptr<Library> load_library(const std::vector<std::string>& files, std::vector<std::string>&& contents) {
+    auto library = std::make_unique<Library>();
+    library->contents = std::move(contents);
+
+    std::ostream null_stream(nullptr);
+    log::Output null_out(null_stream, false);
+    Locator locator;
+    Log log(null_out, &locator);
+    ast::ModDecl module;
+    for (size_t i = 0; i < files.size(); ++i) {
+        locator.register_file(files[i], library->contents[i]);
+        MemBuf mem_buf(library->contents[i]);
+        std::istream is(&mem_buf);
+
+        Lexer lexer(log, files[i], is);
+        Parser parser(log, lexer);
+        auto file_module = parser.parse();
+        module.decls.insert(
+            module.decls.end(),
+            std::make_move_iterator(file_module->decls.begin()),
+            std::make_move_iterator(file_module->decls.end())
+        );
+    }
+    if (log.errors > 0 || log.warns > 0)
+        return nullptr;
+
+    NameBinder name_binder(log);
+    if (!name_binder.run(module))
+        return nullptr;
+    auto warns = log.warns;
+    TypeChecker type_checker(log, library->type_table);
+    if (!type_checker.run(module) || log.warns > warns)
+        return nullptr;
+    library->decls = std::move(module.decls);
+    return library;
+}
+
+static bool compile(const ProgramOptions& opts, Log& log, int& exit_code, Library* library = nullptr) {
+    // Library files come first, and are not read again if they are already in memory
+    auto files = opts.libraries;
+    files.insert(files.end(), opts.files.begin(), opts.files.end());
+    size_t first_file = library ? library->contents.size() : 0;
     std::vector<std::string> contents;
-    for (auto& file : opts.files) {
-        auto data = read_file(file);
+    for (size_t i = first_file; i < files.size(); ++i) {
+        auto data = read_file(files[i]);
+        if (!data) {
+            log::error("cannot open file '{}'", files[i]);
+            return false;
+        }
+        contents.emplace_back(std::move(*data));
+    }
+    std::vector<std::string_view> all_contents;
+    for (size_t i = 0; i < files.size(); ++i)
+        all_contents.emplace_back(i < first_file ? library->contents[i] : contents[i - first_file]);
+    std::vector<std::string> module_data;
+    for (auto& module_file : opts.modules) {
+        auto data = read_file(module_file);
         if (!data) {
-            log::error("cannot open file '{}'", file);
+            log::error("cannot open file '{}'", module_file);
             return false;
         }
-        // The contents are necessary to be able to emit proper diagnostics during type-checking
-        contents.emplace_back(*data);
-        log.locator->register_file(file, contents.back());
-        MemBuf mem_buf(contents.back());
+        module_data.emplace_back(std::move(*data));
+    }
+
+    // Options that print to the standard output or run the program are not cached, and neither are the
+    // compilations that produce warnings, so that a cache hit always has the same effect as a compilation.
+    std::optional<Cache> cache;
+    std::string key;
+    if (!opts.cache_dir.empty() && (opts.emit_llvm || opts.emit_bc || opts.emit_obj) &&
+        !opts.run && !opts.print_ast && !opts.emit_thorin && !opts.mono_report && !opts.emit_module) {
+        cache.emplace(opts.cache_dir, opts.cache_size.value_or(1024) * 1024 * 1024);
+        key = cache_key(opts, files, all_contents, module_data);
+        if (cache->restore(key, opts.module_name))
+            return true;
+    }
+
+    // The contents are necessary to be able to emit proper diagnostics during type-checking
+    for (size_t i = 0; i < files.size(); ++i)
+        log.locator->register_file(files[i], all_contents[i]);
+
+    // Modules carry the contents of their source files for the same reason
+    std::vector<std::unique_ptr<ModuleFile>> modules;
+    for (size_t i = 0; i < opts.modules.size(); ++i) {
+        auto module = ModuleFile::read(module_data[i]);
+        if (!module) {
+            log::error("'{}' is not a valid module file for this version of the compiler", opts.modules[i]);
+            return false;
+        }
+        for (size_t j = 0; j < module->files.size(); ++j)
+            log.locator->register_file(module->files[j], module->contents[j]);
+        modules.emplace_back(std::move(module));
+    }
+
+    // The declarations of the library are given back to it once the program is compiled,
+    // and the types created for the program are removed from the type table of the library
+    ast::ModDecl program;
+    struct LibraryDecls {
+        Library* library;
+        ast::ModDecl& program;
+        size_t count;
+        size_t types;
+
+        ~LibraryDecls() {
+            if (library) {
+                library->decls.assign(
+                    std::make_move_iterator(program.decls.begin()),
+                    std::make_move_iterator(program.decls.begin() + count));
+                library->type_table.rollback(types);
+            }
+        }
+    } library_decls {
+        library, program,
+        library ? library->decls.size() : 0,
+        library ? library->type_table.checkpoint() : 0
+    };
+    if (library)
+        program.decls = std::move(library->decls);
+    for (auto& module : modules) {
+        program.decls.insert(
+            program.decls.end(),
+            std::make_move_iterator(module->decls.begin()),
+            std::make_move_iterator(module->decls.end())
+        );
+    }
+
+    size_t first_decl = program.decls.size();
+    for (size_t i = first_file; i < files.size(); ++i) {
+        auto& file = files[i];
+        if (i == opts.libraries.size())
+            first_decl = program.decls.size();
+        MemBuf mem_buf(contents[i - first_file]);
         std::istream is(&mem_buf);
 
         Lexer lexer(log, file, is);
         Parser parser(log, lexer);
         parser.warns_as_errors = opts.warns_as_errors;
+        // Printed ASTs and modules need every function body
+        parser.lazy_fn_bodies = opts.lazy_parsing && !opts.print_ast && !opts.emit_module;
         auto module = parser.parse();
         if (log.errors > 0)
             return false;
@@ -292,12 +885,27 @@ static bool compile(const ProgramOptions& opts, Log& log) {
         );
     }
 
+    // Modules only contain the declarations of the input files, and are serialized
+    // now, since name binding and type-checking modify the AST
+    std::string module_contents;
+    if (opts.emit_module) {
+        std::vector<const ast::Decl*> decls;
+        for (size_t i = first_decl; i < program.decls.size(); ++i)
+            decls.push_back(program.decls[i].get());
+        module_contents = ModuleFile::write(
+            opts.files,
+            std::vector<std::string_view>(all_contents.begin() + opts.libraries.size(), all_contents.end()),
+            decls);
+    }
+
     NameBinder name_binder(log);
     name_binder.warns_as_errors = opts.warns_as_errors;
     if (opts.enable_all_warns)
         name_binder.warn_on_shadowing = true;
 
-    TypeTable type_table;
+    // Types of the library are kept in its own table
+    TypeTable program_type_table;
+    TypeTable& type_table = library ? library->type_table : program_type_table;
     TypeChecker type_checker(log, type_table);
     type_checker.warns_as_errors = opts.warns_as_errors;
 
@@ -310,65 +918,414 @@ static bool compile(const ProgramOptions& opts, Log& log) {
     if (!name_binder.run(program) || !type_checker.run(program))
         return false;
 
+    // Only modules that type-check are written
+    if (opts.emit_module) {
+        auto name = opts.module_name + ".artm";
+        std::ofstream file(name, std::ios::binary);
+        if (!(file << module_contents)) {
+            log::error("cannot open '{}' for writing", name);
+            return false;
+        }
+    }
+
     thorin::Log::set(opts.log_level, &std::cerr);
     thorin::World world(opts.module_name);
     Emitter emitter(log, world);
     emitter.warns_as_errors = opts.warns_as_errors;
+    emitter.only_reachable = opts.only_reachable;
+    emitter.share_ptr_instances = opts.share_ptr_instances;
+    emitter.mono_report = opts.mono_report;
+    if (opts.by_ref_threshold)
+        emitter.by_ref_threshold = *opts.by_ref_threshold;
+    emitter.hints.fast_math = opts.fast_math;
+    emitter.hints.target_cpu = opts.target_cpu;
+    emitter.hints.target_features = opts.target_features;
     if (!emitter.run(program))
         return false;
     if (opts.opt_level == 1)
         world.cleanup();
-    if (opts.opt_level > 1 || opts.emit_llvm)
+    bool emit_host = opts.emit_llvm || opts.emit_bc || opts.emit_obj || opts.run;
+    if (opts.opt_level > 1 || emit_host)
         world.opt();
     if (opts.emit_thorin)
         world.dump();
 #ifdef ENABLE_LLVM
-    if (opts.emit_llvm) {
+    if (emit_host) {
         thorin::Backends backends(world);
+        bool success = true;
+        // LLVM targets are registered once, before any backend runs
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmPrinters();
+
+        // Some built-in functions, hints, and aligned structures are not supported by every device backend
+        using DeviceBackend = std::tuple<thorin::CodeGen*, const char*, bool>;
+        for (auto [cg, backend, is_llvm_backend] : {
+            DeviceBackend(backends.cuda_cg.get(),   "CUDA",   false),
+            DeviceBackend(backends.nvvm_cg.get(),   "NVVM",   true),
+            DeviceBackend(backends.opencl_cg.get(), "OpenCL", false),
+            DeviceBackend(backends.amdgpu_cg.get(), "AMDGPU", true),
+            DeviceBackend(backends.hls_cg.get(),    "HLS",    false)
+        }) {
+            if (cg)
+                success &= emitter.check_device_code(cg->world(), backend, is_llvm_backend);
+        }
+        if (!success)
+            return false;
+
+        // Backends run one after the other: They share the Thorin log and its stream, as well as the global
+        // state of LLVM for the backends based on it, none of which are meant to be used by several threads.
+        std::vector<std::string> outputs;
         auto emit_to_file = [&](thorin::CodeGen* cg, std::string ext) {
             if (cg) {
                 auto name = opts.module_name + ext;
                 std::ofstream file(name);
-                if (!file)
-                    log::error("cannot open '{}' for writing", name);
-                else
+                if (file) {
                     cg->emit(file, opts.opt_level, opts.debug);
+                    file.close();
+                }
+                if (!file) {
+                    log::error("cannot write '{}'", name);
+                    success = false;
+                } else
+                    outputs.push_back(ext);
             }
         };
-        emit_to_file(backends.cpu_cg.get(),    ".ll");
+
         emit_to_file(backends.cuda_cg.get(),   ".cu");
         emit_to_file(backends.nvvm_cg.get(),   ".nvvm");
         emit_to_file(backends.opencl_cg.get(), ".cl");
         emit_to_file(backends.amdgpu_cg.get(), ".amdgpu");
         emit_to_file(backends.hls_cg.get(),    ".hls");
+
+        if (backends.cpu_cg) {
+            // Hints only apply to host code, which stays in memory until it is written.
+            // They are added before the module is optimized, so that the optimizer can use them.
+            auto& module = backends.cpu_cg->emit(0, opts.debug);
+            emitter.hints.apply(world, *module);
+            auto machine = select_target(opts, *module);
+            success &= machine != nullptr;
+            if (machine) {
+                optimize_llvm_module(opts, *machine, *module);
+                for (auto [emit, ext] : { std::pair(opts.emit_llvm, ".ll"), std::pair(opts.emit_bc, ".bc"), std::pair(opts.emit_obj, ".o") }) {
+                    if (emit && (success &= emit_llvm_module(opts, *machine, *module, ext)))
+                        outputs.emplace_back(ext);
+                }
+            }
+            if (opts.run && success) {
+                auto status = run_llvm_module(opts, *module);
+                success &= status.has_value();
+                exit_code = status.value_or(EXIT_FAILURE);
+            }
+        }
+
+        if (cache && success && log.errors == 0 && log.warns == 0)
+            cache->store(key, opts.module_name, outputs);
+        return success;
     }
 #endif
     return true;
 }
 
-int main(int argc, char** argv) {
-    ProgramOptions opts;
-    if (!opts.parse(argc, argv))
-        return EXIT_FAILURE;
-    if (opts.exit)
-        return EXIT_SUCCESS;
-
+/// Compiles the program given by the options, and prints the diagnostics. Returns the exit code of the compiler.
+static int run_compiler(ProgramOptions& opts, Library* library = nullptr) {
     if (opts.no_color)
         log::err.colorized = log::out.colorized = false;
 
-    if (opts.files.empty()) {
+#ifdef ENABLE_LLVM
+    if (opts.run && !opts.target_triple.empty()) {
+        log::error("option '--run' cannot be used with '--target'");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    if (opts.cache_stats && opts.cache_dir.empty()) {
+        log::error("option '--cache-stats' requires a cache directory");
+        return EXIT_FAILURE;
+    }
+
+    // Programs can be made only of modules
+    if (opts.files.empty() && (opts.modules.empty() || opts.emit_module)) {
+        if (opts.cache_stats) {
+            print_cache_stats(opts.cache_dir);
+            return EXIT_SUCCESS;
+        }
         log::error("no input files");
         return EXIT_FAILURE;
     }
 
     if (opts.module_name == "")
-        opts.module_name = file_without_ext(opts.files.front());
+        opts.module_name = file_without_ext(opts.files.empty() ? opts.modules.front() : opts.files.front());
+#ifdef ENABLE_LLVM
+    if (opts.target_cpu == "native")
+        resolve_native_cpu(opts);
+#endif
 
     Locator locator;
     Log log(log::err, &locator);
     log.max_errors = opts.max_errors;
 
-    bool success = compile(opts, log);
+    int exit_code = EXIT_SUCCESS;
+    bool success = compile(opts, log, exit_code, library);
     log.print_summary();
-    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (opts.cache_stats)
+        print_cache_stats(opts.cache_dir);
+    return success ? exit_code : EXIT_FAILURE;
+}
+
+#ifdef ENABLE_DAEMON
+// The client sends its working directory and its arguments to the server, which replies with
+// the standard output and error of the compiler, followed by its exit code. Strings are sent
+// with their size first. Both ends run on the same machine, so integers use the native layout.
+
+static bool write_all(int fd, const void* data, size_t size) {
+    auto bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        auto count = write(fd, bytes, size);
+        if (count <= 0)
+            return false;
+        bytes += count, size -= count;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t size) {
+    auto bytes = static_cast<char*>(data);
+    while (size > 0) {
+        auto count = read(fd, bytes, size);
+        if (count <= 0)
+            return false;
+        bytes += count, size -= count;
+    }
+    return true;
+}
+
+static bool write_string(int fd, const std::string& str) {
+    uint32_t size = str.size();
+    return write_all(fd, &size, sizeof(size)) && write_all(fd, str.data(), size);
+}
+
+static std::optional<std::string> read_string(int fd) {
+    uint32_t size = 0;
+    if (!read_all(fd, &size, sizeof(size)))
+        return std::nullopt;
+    std::string str(size, '\0');
+    if (!read_all(fd, str.data(), size))
+        return std::nullopt;
+    return std::make_optional(std::move(str));
+}
+
+static int open_socket(const std::string& path, sockaddr_un& addr) {
+    if (path.size() >= sizeof(addr.sun_path)) {
+        log::error("socket path '{}' is too long", path);
+        return -1;
+    }
+    addr = sockaddr_un {};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+/// Libraries kept in memory by the server, keyed by their file names and contents.
+/// Libraries that cannot be kept in memory (see `load_library`) are recorded as well, so that
+/// they are not loaded again. The least recently used libraries are evicted first.
+struct LibraryCache {
+    static constexpr size_t max_libraries = 8;
+
+    std::unordered_map<std::string, std::unique_ptr<Library>> libraries;
+    std::vector<std::string> keys;
+
+    Library* find(const std::vector<std::string>& files) {
+        std::vector<std::string> contents;
+        // Every input is prefixed by its size, as in `cache_key`
+        std::string key;
+        auto combine = [&] (const std::string& str) {
+            key += std::to_string(str.size());
+            key += ':';
+            key += str;
+        };
+        for (auto& file : files) {
+            auto data = read_file(file);
+            // Missing files are reported when compiling the program
+            if (!data)
+                return nullptr;
+            combine(file);
+            combine(*data);
+            contents.emplace_back(std::move(*data));
+        }
+
+        if (auto it = libraries.find(key); it != libraries.end()) {
+            keys.erase(std::find(keys.begin(), keys.end(), key));
+            keys.push_back(key);
+            return it->second.get();
+        }
+        if (keys.size() >= max_libraries) {
+            libraries.erase(keys.front());
+            keys.erase(keys.begin());
+        }
+        keys.push_back(key);
+        return libraries.emplace(std::move(key), load_library(files, std::move(contents))).first->second.get();
+    }
+};
+
+static int serve_request(std::vector<std::string>& args, LibraryCache& library_cache) {
+    std::vector<char*> argv { const_cast<char*>("artic") };
+    for (auto& arg : args)
+        argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    ProgramOptions opts;
+    if (!opts.parse(static_cast<int>(args.size() + 1), argv.data()))
+        return EXIT_FAILURE;
+    if (opts.exit)
+        return EXIT_SUCCESS;
+    if (!opts.daemon_socket.empty() || opts.run) {
+        log::error("option '{}' is not supported by the compiler server", opts.run ? "--run" : "--daemon");
+        return EXIT_FAILURE;
+    }
+    auto library = opts.libraries.empty() ? nullptr : library_cache.find(opts.libraries);
+    return run_compiler(opts, library);
+}
+
+static void serve_client(int client, LibraryCache& library_cache) {
+    auto cwd = read_string(client);
+    uint32_t arg_count = 0;
+    if (!cwd || !read_all(client, &arg_count, sizeof(arg_count)))
+        return;
+    std::vector<std::string> args;
+    for (uint32_t i = 0; i < arg_count; ++i) {
+        auto arg = read_string(client);
+        if (!arg)
+            return;
+        args.emplace_back(std::move(*arg));
+    }
+
+    // Diagnostics are never colorized, since they are not printed to a terminal
+    std::ostringstream out, err;
+    auto out_buf = std::cout.rdbuf(out.rdbuf());
+    auto err_buf = std::cerr.rdbuf(err.rdbuf());
+    log::err.colorized = log::out.colorized = false;
+    int32_t exit_code = EXIT_FAILURE;
+    if (chdir(cwd->c_str()) != 0)
+        log::error("cannot change directory to '{}'", *cwd);
+    else
+        exit_code = serve_request(args, library_cache);
+    std::cout.flush();
+    std::cerr.flush();
+    std::cout.rdbuf(out_buf);
+    std::cerr.rdbuf(err_buf);
+
+    if (write_string(client, out.str()) && write_string(client, err.str()))
+        write_all(client, &exit_code, sizeof(exit_code));
+}
+
+/// Runs the compiler server, which handles the requests of the clients one at a time.
+static int run_daemon(const std::string& path) {
+    sockaddr_un addr;
+    int server = open_socket(path, addr);
+    if (server < 0)
+        return EXIT_FAILURE;
+    // Sockets left by a previous server are replaced, but other files are never removed
+    struct stat path_stat;
+    if (lstat(path.c_str(), &path_stat) == 0) {
+        if (!S_ISSOCK(path_stat.st_mode)) {
+            log::error("cannot listen on '{}', which exists and is not a socket", path);
+            close(server);
+            return EXIT_FAILURE;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(server, SOMAXCONN) != 0) {
+        log::error("cannot listen on socket '{}'", path);
+        close(server);
+        return EXIT_FAILURE;
+    }
+    // Clients that disconnect early should not terminate the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    LibraryCache library_cache;
+    while (true) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        serve_client(client, library_cache);
+        close(client);
+    }
+}
+
+/// Sends the command line to the compiler server listening on the given socket, and prints its outputs.
+/// Returns nothing if the server cannot be reached, in which case the program should be compiled locally.
+static std::optional<int> run_client(const std::string& path, int argc, char** argv) {
+    sockaddr_un addr;
+    int client = open_socket(path, addr);
+    if (client < 0)
+        return std::nullopt;
+    if (connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(client);
+        return std::nullopt;
+    }
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--")) {
+            args.insert(args.end(), argv + i, argv + argc);
+            break;
+        }
+        if (!strcmp(argv[i], "--connect"))
+            i++;
+        else
+            args.emplace_back(argv[i]);
+    }
+    std::error_code err;
+    bool sent = write_string(client, std::filesystem::current_path(err).string());
+    uint32_t arg_count = args.size();
+    sent &= write_all(client, &arg_count, sizeof(arg_count));
+    for (auto& arg : args)
+        sent = sent && write_string(client, arg);
+
+    std::optional<std::string> out, err_out;
+    int32_t exit_code = EXIT_FAILURE;
+    if (sent &&
+        (out = read_string(client)) &&
+        (err_out = read_string(client)) &&
+        read_all(client, &exit_code, sizeof(exit_code)))
+    {
+        log::out.stream << *out << std::flush;
+        log::err.stream << *err_out << std::flush;
+    } else {
+        log::error("lost connection to the compiler server on '{}'", path);
+        exit_code = EXIT_FAILURE;
+    }
+    close(client);
+    return std::make_optional<int>(exit_code);
+}
+#endif
+
+int main(int argc, char** argv) {
+    ProgramOptions opts;
+    if (!opts.parse(argc, argv))
+        return EXIT_FAILURE;
+    if (opts.exit)
+        return EXIT_SUCCESS;
+
+#ifdef ENABLE_DAEMON
+    if (!opts.daemon_socket.empty()) {
+        if (!opts.connect_socket.empty()) {
+            log::error("options '--daemon' and '--connect' cannot be used together");
+            return EXIT_FAILURE;
+        }
+        if (!opts.files.empty()) {
+            log::error("the compiler server does not take input files");
+            return EXIT_FAILURE;
+        }
+        return run_daemon(opts.daemon_socket);
+    }
+    // Programs that are run are always compiled locally, since they would run in the server otherwise
+    if (!opts.connect_socket.empty() && !opts.run) {
+        if (auto exit_code = run_client(opts.connect_socket, argc, argv))
+            return *exit_code;
+    }
+#endif
+    return run_compiler(opts);
 }
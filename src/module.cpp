@@ -0,0 +1,989 @@
+#include "artic/module.h"
+#include "artic/hash.h"
+
+#include <unordered_map>
+#include <cassert>
+#include <cstring>
+
+namespace artic {
+
+static constexpr char magic[] = { 'A', 'R', 'T', 'M' };
+static constexpr size_t header_size = sizeof(magic) + sizeof(uint32_t) + sizeof(uint64_t);
+
+/// Kinds of the nodes stored in a module file.
+enum class NodeKind : uint8_t {
+    Null,
+    AttrList, NamedAttr, PathAttr, TypeAttr, LiteralAttr,
+    PrimType, TupleType, SizedArrayType, UnsizedArrayType, FnType, PtrType, TypeApp, ErrorType,
+    DeclStmt, ExprStmt,
+    TypedExpr, PathExpr, LiteralExpr, FieldExpr, StructExpr, TupleExpr, ArrayExpr, RepeatArrayExpr,
+    FnExpr, BlockExpr, CallExpr, ProjExpr, IfExpr, CaseExpr, MatchExpr, WhileExpr, ForExpr,
+    BreakExpr, ContinueExpr, ReturnExpr, UnaryExpr, BinaryExpr, FilterExpr, CastExpr, AsmExpr, ErrorExpr,
+    TypeParam, TypeParamList, PtrnDecl, LetDecl, StaticDecl, FnDecl, FieldDecl,
+    StructDecl, OptionDecl, EnumDecl, TypeDecl, ModDecl, ErrorDecl,
+    TypedPtrn, IdPtrn, LiteralPtrn, FieldPtrn, StructPtrn, EnumPtrn, TuplePtrn, ErrorPtrn,
+    Filter
+};
+
+// The header uses fixed-size little-endian integers, so that it can be checked before reading the rest.
+
+static void write_fixed(std::string& data, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        data.push_back(static_cast<char>(value >> (i * 8)));
+}
+
+static uint64_t read_fixed(std::string_view data, size_t pos, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+        value |= uint64_t(static_cast<uint8_t>(data[pos + i])) << (i * 8);
+    return value;
+}
+
+// Locations are stored relative to the previous one, and signed integers are
+// zig-zag encoded, so that small differences take a single byte.
+
+static uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+struct ModuleWriter {
+    std::string data;
+    std::vector<std::string> files;
+    std::unordered_map<std::string, size_t> file_indices;
+    int last_row = 0, last_col = 0;
+
+    /// Registers a file, and returns its index. Index 0 is for locations without a file.
+    size_t add_file(const std::string& file) {
+        auto [it, inserted] = file_indices.emplace(file, files.size() + 1);
+        if (inserted)
+            files.push_back(file);
+        return it->second;
+    }
+
+    // Integers are written with 7 bits per byte, and the high bit set on all bytes but the last
+    void write_int(uint64_t value) {
+        for (; value >= 0x80; value >>= 7)
+            data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        data.push_back(static_cast<char>(value));
+    }
+
+    void write_str(std::string_view str) {
+        write_int(str.size());
+        data.append(str);
+    }
+
+    void write_loc(const Loc& loc) {
+        if (!loc.file)
+            return write_int(0);
+        write_int(add_file(*loc.file));
+        write_int(zigzag(int64_t(loc.begin.row) - last_row));
+        write_int(zigzag(int64_t(loc.begin.col) - last_col));
+        write_int(zigzag(int64_t(loc.end.row) - loc.begin.row));
+        write_int(zigzag(int64_t(loc.end.col) - loc.begin.col));
+        last_row = loc.begin.row;
+        last_col = loc.begin.col;
+    }
+
+    void write_id(const ast::Identifier& id) {
+        write_loc(id.loc);
+        write_str(id.name);
+    }
+
+    void write_lit(const Literal& lit) {
+        write_int(lit.tag);
+        switch (lit.tag) {
+            case Literal::Char:    write_int(lit.as_char());    break;
+            case Literal::String:  write_str(lit.as_string());  break;
+            case Literal::Integer: write_int(lit.as_integer()); break;
+            case Literal::Bool:    write_int(lit.as_bool());    break;
+            case Literal::Double: {
+                uint64_t bits;
+                auto value = lit.as_double();
+                std::memcpy(&bits, &value, sizeof(bits));
+                write_int(bits);
+                break;
+            }
+        }
+    }
+
+    void write_path(const ast::Path& path) {
+        write_loc(path.loc);
+        write_int(path.elems.size());
+        for (auto& elem : path.elems) {
+            write_loc(elem.loc);
+            write_id(elem.id);
+            write_nodes(elem.args);
+        }
+    }
+
+    void write_constrs(const std::vector<ast::AsmExpr::Constr>& constrs) {
+        write_int(constrs.size());
+        for (auto& constr : constrs) {
+            write_loc(constr.loc);
+            write_str(constr.name);
+            write_node(constr.expr.get());
+        }
+    }
+
+    void write_strs(const std::vector<std::string>& strs) {
+        write_int(strs.size());
+        for (auto& str : strs)
+            write_str(str);
+    }
+
+    template <typename T>
+    void write_nodes(const PtrVector<T>& nodes) {
+        write_int(nodes.size());
+        for (auto& node : nodes)
+            write_node(node.get());
+    }
+
+    void write_header(NodeKind kind, const ast::Node& node) {
+        write_int(static_cast<uint64_t>(kind));
+        write_loc(node.loc);
+    }
+
+    void write_node(const ast::Node* node) {
+        if (!node)
+            return write_int(static_cast<uint64_t>(NodeKind::Null));
+        write_fields(*node);
+        write_node(node->attrs.get());
+        if (auto decl = node->isa<ast::Decl>())
+            write_int(decl->is_top_level);
+    }
+
+    void write_fields(const ast::Node& node) {
+        // Attributes
+        if (auto attr_list = node.isa<ast::AttrList>()) {
+            write_header(NodeKind::AttrList, node);
+            write_nodes(attr_list->args);
+        } else if (auto named_attr = node.isa<ast::NamedAttr>()) {
+            write_header(NodeKind::NamedAttr, node);
+            write_str(named_attr->name);
+            write_nodes(named_attr->args);
+        } else if (auto path_attr = node.isa<ast::PathAttr>()) {
+            write_header(NodeKind::PathAttr, node);
+            write_str(path_attr->name);
+            write_path(path_attr->path);
+        } else if (auto type_attr = node.isa<ast::TypeAttr>()) {
+            write_header(NodeKind::TypeAttr, node);
+            write_str(type_attr->name);
+            write_node(type_attr->type.get());
+        } else if (auto literal_attr = node.isa<ast::LiteralAttr>()) {
+            write_header(NodeKind::LiteralAttr, node);
+            write_str(literal_attr->name);
+            write_lit(literal_attr->lit);
+        }
+        // Types
+        else if (auto prim_type = node.isa<ast::PrimType>()) {
+            write_header(NodeKind::PrimType, node);
+            write_int(prim_type->tag);
+        } else if (auto tuple_type = node.isa<ast::TupleType>()) {
+            write_header(NodeKind::TupleType, node);
+            write_nodes(tuple_type->args);
+        } else if (auto sized_array_type = node.isa<ast::SizedArrayType>()) {
+            write_header(NodeKind::SizedArrayType, node);
+            write_node(sized_array_type->elem.get());
+            write_int(sized_array_type->size);
+            write_int(sized_array_type->is_simd);
+        } else if (auto unsized_array_type = node.isa<ast::UnsizedArrayType>()) {
+            write_header(NodeKind::UnsizedArrayType, node);
+            write_node(unsized_array_type->elem.get());
+        } else if (auto fn_type = node.isa<ast::FnType>()) {
+            write_header(NodeKind::FnType, node);
+            write_node(fn_type->from.get());
+            write_node(fn_type->to.get());
+        } else if (auto ptr_type = node.isa<ast::PtrType>()) {
+            write_header(NodeKind::PtrType, node);
+            write_node(ptr_type->pointee.get());
+            write_int(ptr_type->is_mut);
+            write_int(ptr_type->is_noalias);
+            write_int(ptr_type->addr_space);
+        } else if (auto type_app = node.isa<ast::TypeApp>()) {
+            write_header(NodeKind::TypeApp, node);
+            write_path(type_app->path);
+        } else if (node.isa<ast::ErrorType>()) {
+            write_header(NodeKind::ErrorType, node);
+        }
+        // Statements
+        else if (auto decl_stmt = node.isa<ast::DeclStmt>()) {
+            write_header(NodeKind::DeclStmt, node);
+            write_node(decl_stmt->decl.get());
+        } else if (auto expr_stmt = node.isa<ast::ExprStmt>()) {
+            write_header(NodeKind::ExprStmt, node);
+            write_node(expr_stmt->expr.get());
+        }
+        // Expressions
+        else if (auto typed_expr = node.isa<ast::TypedExpr>()) {
+            write_header(NodeKind::TypedExpr, node);
+            write_node(typed_expr->expr.get());
+            write_node(typed_expr->type.get());
+        } else if (auto path_expr = node.isa<ast::PathExpr>()) {
+            write_header(NodeKind::PathExpr, node);
+            write_path(path_expr->path);
+        } else if (auto literal_expr = node.isa<ast::LiteralExpr>()) {
+            write_header(NodeKind::LiteralExpr, node);
+            write_lit(literal_expr->lit);
+        } else if (auto field_expr = node.isa<ast::FieldExpr>()) {
+            write_header(NodeKind::FieldExpr, node);
+            write_id(field_expr->id);
+            write_node(field_expr->expr.get());
+        } else if (auto struct_expr = node.isa<ast::StructExpr>()) {
+            write_header(NodeKind::StructExpr, node);
+            write_node(struct_expr->type.get());
+            write_node(struct_expr->expr.get());
+            write_nodes(struct_expr->fields);
+        } else if (auto tuple_expr = node.isa<ast::TupleExpr>()) {
+            write_header(NodeKind::TupleExpr, node);
+            write_nodes(tuple_expr->args);
+        } else if (auto array_expr = node.isa<ast::ArrayExpr>()) {
+            write_header(NodeKind::ArrayExpr, node);
+            write_nodes(array_expr->elems);
+            write_int(array_expr->is_simd);
+        } else if (auto repeat_array_expr = node.isa<ast::RepeatArrayExpr>()) {
+            write_header(NodeKind::RepeatArrayExpr, node);
+            write_node(repeat_array_expr->elem.get());
+            write_int(repeat_array_expr->size);
+            write_int(repeat_array_expr->is_simd);
+        } else if (auto fn_expr = node.isa<ast::FnExpr>()) {
+            write_header(NodeKind::FnExpr, node);
+            write_node(fn_expr->filter.get());
+            write_node(fn_expr->param.get());
+            write_node(fn_expr->ret_type.get());
+            write_node(fn_expr->body.get());
+        } else if (auto block_expr = node.isa<ast::BlockExpr>()) {
+            write_header(NodeKind::BlockExpr, node);
+            write_nodes(block_expr->stmts);
+            write_int(block_expr->last_semi);
+        } else if (auto call_expr = node.isa<ast::CallExpr>()) {
+            write_header(NodeKind::CallExpr, node);
+            write_node(call_expr->callee.get());
+            write_node(call_expr->arg.get());
+        } else if (auto proj_expr = node.isa<ast::ProjExpr>()) {
+            write_header(NodeKind::ProjExpr, node);
+            write_node(proj_expr->expr.get());
+            write_id(proj_expr->field);
+        } else if (auto if_expr = node.isa<ast::IfExpr>()) {
+            write_header(NodeKind::IfExpr, node);
+            write_node(if_expr->cond.get());
+            write_node(if_expr->if_true.get());
+            write_node(if_expr->if_false.get());
+        } else if (auto case_expr = node.isa<ast::CaseExpr>()) {
+            write_header(NodeKind::CaseExpr, node);
+            write_node(case_expr->ptrn.get());
+            write_node(case_expr->expr.get());
+        } else if (auto match_expr = node.isa<ast::MatchExpr>()) {
+            write_header(NodeKind::MatchExpr, node);
+            write_node(match_expr->arg.get());
+            write_nodes(match_expr->cases);
+        } else if (auto while_expr = node.isa<ast::WhileExpr>()) {
+            write_header(NodeKind::WhileExpr, node);
+            write_node(while_expr->cond.get());
+            write_node(while_expr->body.get());
+        } else if (auto for_expr = node.isa<ast::ForExpr>()) {
+            write_header(NodeKind::ForExpr, node);
+            write_node(for_expr->call.get());
+        } else if (node.isa<ast::BreakExpr>()) {
+            write_header(NodeKind::BreakExpr, node);
+        } else if (node.isa<ast::ContinueExpr>()) {
+            write_header(NodeKind::ContinueExpr, node);
+        } else if (node.isa<ast::ReturnExpr>()) {
+            write_header(NodeKind::ReturnExpr, node);
+        } else if (auto unary_expr = node.isa<ast::UnaryExpr>()) {
+            write_header(NodeKind::UnaryExpr, node);
+            write_int(unary_expr->tag);
+            write_node(unary_expr->arg.get());
+        } else if (auto binary_expr = node.isa<ast::BinaryExpr>()) {
+            write_header(NodeKind::BinaryExpr, node);
+            write_int(binary_expr->tag);
+            write_node(binary_expr->left.get());
+            write_node(binary_expr->right.get());
+        } else if (auto filter_expr = node.isa<ast::FilterExpr>()) {
+            write_header(NodeKind::FilterExpr, node);
+            write_node(filter_expr->filter.get());
+            write_node(filter_expr->expr.get());
+        } else if (auto cast_expr = node.isa<ast::CastExpr>()) {
+            write_header(NodeKind::CastExpr, node);
+            write_node(cast_expr->expr.get());
+            write_node(cast_expr->type.get());
+        } else if (auto asm_expr = node.isa<ast::AsmExpr>()) {
+            write_header(NodeKind::AsmExpr, node);
+            write_str(asm_expr->src);
+            write_constrs(asm_expr->ins);
+            write_constrs(asm_expr->outs);
+            write_strs(asm_expr->clobs);
+            write_strs(asm_expr->opts);
+        } else if (node.isa<ast::ErrorExpr>()) {
+            write_header(NodeKind::ErrorExpr, node);
+        }
+        // Declarations
+        else if (auto type_param = node.isa<ast::TypeParam>()) {
+            write_header(NodeKind::TypeParam, node);
+            write_id(type_param->id);
+        } else if (auto type_param_list = node.isa<ast::TypeParamList>()) {
+            write_header(NodeKind::TypeParamList, node);
+            write_nodes(type_param_list->params);
+        } else if (auto ptrn_decl = node.isa<ast::PtrnDecl>()) {
+            write_header(NodeKind::PtrnDecl, node);
+            write_id(ptrn_decl->id);
+            write_int(ptrn_decl->is_mut);
+        } else if (auto let_decl = node.isa<ast::LetDecl>()) {
+            write_header(NodeKind::LetDecl, node);
+            write_node(let_decl->ptrn.get());
+            write_node(let_decl->init.get());
+        } else if (auto static_decl = node.isa<ast::StaticDecl>()) {
+            write_header(NodeKind::StaticDecl, node);
+            write_id(static_decl->id);
+            write_node(static_decl->type.get());
+            write_node(static_decl->init.get());
+            write_int(static_decl->is_mut);
+        } else if (auto fn_decl = node.isa<ast::FnDecl>()) {
+            write_header(NodeKind::FnDecl, node);
+            write_id(fn_decl->id);
+            write_node(fn_decl->fn.get());
+            write_node(fn_decl->type_params.get());
+        } else if (auto field_decl = node.isa<ast::FieldDecl>()) {
+            write_header(NodeKind::FieldDecl, node);
+            write_id(field_decl->id);
+            write_node(field_decl->type.get());
+            write_node(field_decl->init.get());
+        } else if (auto struct_decl = node.isa<ast::StructDecl>()) {
+            write_header(NodeKind::StructDecl, node);
+            write_id(struct_decl->id);
+            write_node(struct_decl->type_params.get());
+            write_nodes(struct_decl->fields);
+        } else if (auto option_decl = node.isa<ast::OptionDecl>()) {
+            write_header(NodeKind::OptionDecl, node);
+            write_id(option_decl->id);
+            write_node(option_decl->param.get());
+        } else if (auto enum_decl = node.isa<ast::EnumDecl>()) {
+            write_header(NodeKind::EnumDecl, node);
+            write_id(enum_decl->id);
+            write_node(enum_decl->type_params.get());
+            write_nodes(enum_decl->options);
+        } else if (auto type_decl = node.isa<ast::TypeDecl>()) {
+            write_header(NodeKind::TypeDecl, node);
+            write_id(type_decl->id);
+            write_node(type_decl->type_params.get());
+            write_node(type_decl->aliased_type.get());
+        } else if (auto mod_decl = node.isa<ast::ModDecl>()) {
+            write_header(NodeKind::ModDecl, node);
+            write_id(mod_decl->id);
+            write_nodes(mod_decl->decls);
+        } else if (node.isa<ast::ErrorDecl>()) {
+            write_header(NodeKind::ErrorDecl, node);
+        }
+        // Patterns
+        else if (auto typed_ptrn = node.isa<ast::TypedPtrn>()) {
+            write_header(NodeKind::TypedPtrn, node);
+            write_node(typed_ptrn->ptrn.get());
+            write_node(typed_ptrn->type.get());
+        } else if (auto id_ptrn = node.isa<ast::IdPtrn>()) {
+            write_header(NodeKind::IdPtrn, node);
+            write_node(id_ptrn->decl.get());
+            write_node(id_ptrn->sub_ptrn.get());
+        } else if (auto literal_ptrn = node.isa<ast::LiteralPtrn>()) {
+            write_header(NodeKind::LiteralPtrn, node);
+            write_lit(literal_ptrn->lit);
+        } else if (auto field_ptrn = node.isa<ast::FieldPtrn>()) {
+            write_header(NodeKind::FieldPtrn, node);
+            write_id(field_ptrn->id);
+            write_node(field_ptrn->ptrn.get());
+        } else if (auto struct_ptrn = node.isa<ast::StructPtrn>()) {
+            write_header(NodeKind::StructPtrn, node);
+            write_path(struct_ptrn->path);
+            write_nodes(struct_ptrn->fields);
+        } else if (auto enum_ptrn = node.isa<ast::EnumPtrn>()) {
+            write_header(NodeKind::EnumPtrn, node);
+            write_path(enum_ptrn->path);
+            write_node(enum_ptrn->arg.get());
+        } else if (auto tuple_ptrn = node.isa<ast::TuplePtrn>()) {
+            write_header(NodeKind::TuplePtrn, node);
+            write_nodes(tuple_ptrn->args);
+        } else if (node.isa<ast::ErrorPtrn>()) {
+            write_header(NodeKind::ErrorPtrn, node);
+        }
+        // Filters
+        else if (auto filter = node.isa<ast::Filter>()) {
+            write_header(NodeKind::Filter, node);
+            write_node(filter->expr.get());
+        } else {
+            // Other nodes (e.g. implicit casts) are only created by the type checker
+            assert(false);
+        }
+    }
+};
+
+struct ModuleReader {
+    std::string_view data;
+    size_t pos = 0;
+    bool valid = true;
+    std::vector<std::shared_ptr<std::string>> files;
+    int last_row = 0, last_col = 0;
+
+    ModuleReader(std::string_view data)
+        : data(data)
+    {}
+
+    uint64_t read_int() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+            auto byte = static_cast<uint8_t>(data[pos++]);
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        valid = false;
+        return 0;
+    }
+
+    /// Reads the number of elements of a list. Since every element takes at
+    /// least one byte, this number cannot exceed the number of remaining bytes.
+    size_t read_count() {
+        auto count = read_int();
+        if (count > data.size() - pos) {
+            valid = false;
+            return 0;
+        }
+        return count;
+    }
+
+    bool read_bool() {
+        auto value = read_int();
+        valid &= value <= 1;
+        return value != 0;
+    }
+
+    template <typename T>
+    T read_enum(T max) {
+        auto value = read_int();
+        if (value > static_cast<uint64_t>(max)) {
+            valid = false;
+            return max;
+        }
+        return static_cast<T>(value);
+    }
+
+    std::string read_str() {
+        auto size = read_count();
+        auto str = data.substr(pos, size);
+        pos += size;
+        return std::string(str);
+    }
+
+    std::vector<std::string> read_strs() {
+        std::vector<std::string> strs(read_count());
+        for (auto& str : strs)
+            str = read_str();
+        return strs;
+    }
+
+    int read_coord(int base) {
+        return static_cast<int>(base + unzigzag(read_int()));
+    }
+
+    Loc read_loc() {
+        auto index = read_int();
+        if (index == 0)
+            return Loc();
+        if (index > files.size()) {
+            valid = false;
+            return Loc();
+        }
+        auto begin_row = last_row = read_coord(last_row);
+        auto begin_col = last_col = read_coord(last_col);
+        auto end_row   = read_coord(begin_row);
+        auto end_col   = read_coord(begin_col);
+        return Loc(files[index - 1], begin_row, begin_col, end_row, end_col);
+    }
+
+    ast::Identifier read_id() {
+        auto loc = read_loc();
+        return ast::Identifier(loc, read_str());
+    }
+
+    Literal read_lit() {
+        switch (read_enum(Literal::Bool)) {
+            case Literal::Char: {
+                auto value = read_int();
+                valid &= value <= UINT8_MAX;
+                return Literal(static_cast<uint8_t>(value));
+            }
+            case Literal::String:  return Literal(read_str());
+            case Literal::Integer: return Literal(static_cast<uint64_t>(read_int()));
+            case Literal::Bool:    return Literal(read_bool());
+            case Literal::Double: {
+                double value;
+                auto bits = read_int();
+                std::memcpy(&value, &bits, sizeof(value));
+                return Literal(value);
+            }
+        }
+        return Literal();
+    }
+
+    ast::Path read_path() {
+        auto loc = read_loc();
+        std::vector<ast::Path::Elem> elems;
+        // Paths have at least one element
+        auto count = read_count();
+        valid &= count > 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto elem_loc = read_loc();
+            auto id = read_id();
+            elems.emplace_back(elem_loc, std::move(id), read_nodes<ast::Type>());
+        }
+        return ast::Path(loc, std::move(elems));
+    }
+
+    std::vector<ast::AsmExpr::Constr> read_constrs() {
+        std::vector<ast::AsmExpr::Constr> constrs;
+        for (size_t i = 0, n = read_count(); i < n; ++i) {
+            auto loc = read_loc();
+            auto name = read_str();
+            constrs.emplace_back(loc, std::move(name), read<ast::Expr>());
+        }
+        return constrs;
+    }
+
+    /// Reads an optional node, which may be null, and checks that it has the given type.
+    template <typename T>
+    Ptr<T> read_opt() {
+        auto node = read_node();
+        if (node && !node->isa<T>()) {
+            valid = false;
+            return nullptr;
+        }
+        return Ptr<T>(static_cast<T*>(node.release()));
+    }
+
+    /// Reads a node that cannot be null, and checks that it has the given type.
+    /// The parser never leaves such nodes out, and the rest of the compiler relies on it.
+    template <typename T>
+    Ptr<T> read() {
+        auto node = read_opt<T>();
+        valid &= node != nullptr;
+        return node;
+    }
+
+    template <typename T>
+    PtrVector<T> read_nodes() {
+        PtrVector<T> nodes(read_count());
+        for (auto& node : nodes)
+            node = read<T>();
+        return nodes;
+    }
+
+    Ptr<ast::Node> read_node() {
+        auto kind = valid ? read_enum(NodeKind::Filter) : NodeKind::Null;
+        if (kind == NodeKind::Null)
+            return nullptr;
+
+        // Arguments are read in order, before the node is constructed
+        auto loc = read_loc();
+        Ptr<ast::Node> node;
+        switch (kind) {
+            // Attributes
+            case NodeKind::AttrList: {
+                node = make_ptr<ast::AttrList>(loc, read_nodes<ast::Attr>());
+                break;
+            }
+            case NodeKind::NamedAttr: {
+                auto name = read_str();
+                node = make_ptr<ast::NamedAttr>(loc, std::move(name), read_nodes<ast::Attr>());
+                break;
+            }
+            case NodeKind::PathAttr: {
+                auto name = read_str();
+                node = make_ptr<ast::PathAttr>(loc, std::move(name), read_path());
+                break;
+            }
+            case NodeKind::TypeAttr: {
+                auto name = read_str();
+                node = make_ptr<ast::TypeAttr>(loc, std::move(name), read<ast::Type>());
+                break;
+            }
+            case NodeKind::LiteralAttr: {
+                auto name = read_str();
+                node = make_ptr<ast::LiteralAttr>(loc, std::move(name), read_lit());
+                break;
+            }
+            // Types
+            case NodeKind::PrimType: {
+                node = make_ptr<ast::PrimType>(loc, read_enum(ast::PrimType::Error));
+                break;
+            }
+            case NodeKind::TupleType: {
+                node = make_ptr<ast::TupleType>(loc, read_nodes<ast::Type>());
+                break;
+            }
+            case NodeKind::SizedArrayType: {
+                auto elem = read<ast::Type>();
+                auto size = read_int();
+                node = make_ptr<ast::SizedArrayType>(loc, std::move(elem), size, read_bool());
+                break;
+            }
+            case NodeKind::UnsizedArrayType: {
+                node = make_ptr<ast::UnsizedArrayType>(loc, read<ast::Type>());
+                break;
+            }
+            case NodeKind::FnType: {
+                auto from = read<ast::Type>();
+                node = make_ptr<ast::FnType>(loc, std::move(from), read<ast::Type>());
+                break;
+            }
+            case NodeKind::PtrType: {
+                auto pointee = read<ast::Type>();
+                auto is_mut = read_bool();
+                auto is_noalias = read_bool();
+                node = make_ptr<ast::PtrType>(loc, std::move(pointee), is_mut, is_noalias, read_int());
+                break;
+            }
+            case NodeKind::TypeApp: {
+                node = make_ptr<ast::TypeApp>(loc, read_path());
+                break;
+            }
+            case NodeKind::ErrorType: {
+                node = make_ptr<ast::ErrorType>(loc);
+                break;
+            }
+            // Statements
+            case NodeKind::DeclStmt: {
+                node = make_ptr<ast::DeclStmt>(loc, read<ast::Decl>());
+                break;
+            }
+            case NodeKind::ExprStmt: {
+                node = make_ptr<ast::ExprStmt>(loc, read<ast::Expr>());
+                break;
+            }
+            // Expressions
+            case NodeKind::TypedExpr: {
+                auto expr = read<ast::Expr>();
+                node = make_ptr<ast::TypedExpr>(loc, std::move(expr), read<ast::Type>());
+                break;
+            }
+            case NodeKind::PathExpr: {
+                // The location of the expression may be larger than the one of the path (e.g. `(x)`)
+                node = make_ptr<ast::PathExpr>(read_path());
+                node->loc = loc;
+                break;
+            }
+            case NodeKind::LiteralExpr: {
+                node = make_ptr<ast::LiteralExpr>(loc, read_lit());
+                break;
+            }
+            case NodeKind::FieldExpr: {
+                auto id = read_id();
+                node = make_ptr<ast::FieldExpr>(loc, std::move(id), read<ast::Expr>());
+                break;
+            }
+            case NodeKind::StructExpr: {
+                // Either the type or the expression is present, depending on the constructor used by the parser
+                auto type = read_opt<ast::Type>();
+                auto expr = read_opt<ast::Expr>();
+                auto fields = read_nodes<ast::FieldExpr>();
+                valid &= (type == nullptr) != (expr == nullptr);
+                if (type)
+                    node = make_ptr<ast::StructExpr>(loc, std::move(type), std::move(fields));
+                else
+                    node = make_ptr<ast::StructExpr>(loc, std::move(expr), std::move(fields));
+                break;
+            }
+            case NodeKind::TupleExpr: {
+                node = make_ptr<ast::TupleExpr>(loc, read_nodes<ast::Expr>());
+                break;
+            }
+            case NodeKind::ArrayExpr: {
+                auto elems = read_nodes<ast::Expr>();
+                node = make_ptr<ast::ArrayExpr>(loc, std::move(elems), read_bool());
+                break;
+            }
+            case NodeKind::RepeatArrayExpr: {
+                auto elem = read<ast::Expr>();
+                auto size = read_int();
+                node = make_ptr<ast::RepeatArrayExpr>(loc, std::move(elem), size, read_bool());
+                break;
+            }
+            case NodeKind::FnExpr: {
+                // Prototypes have no body
+                auto filter = read_opt<ast::Filter>();
+                auto param = read<ast::Ptrn>();
+                auto ret_type = read_opt<ast::Type>();
+                node = make_ptr<ast::FnExpr>(loc, std::move(filter), std::move(param), std::move(ret_type), read_opt<ast::Expr>());
+                break;
+            }
+            case NodeKind::BlockExpr: {
+                auto stmts = read_nodes<ast::Stmt>();
+                node = make_ptr<ast::BlockExpr>(loc, std::move(stmts), read_bool());
+                break;
+            }
+            case NodeKind::CallExpr: {
+                auto callee = read<ast::Expr>();
+                node = make_ptr<ast::CallExpr>(loc, std::move(callee), read<ast::Expr>());
+                break;
+            }
+            case NodeKind::ProjExpr: {
+                auto expr = read<ast::Expr>();
+                node = make_ptr<ast::ProjExpr>(loc, std::move(expr), read_id());
+                break;
+            }
+            case NodeKind::IfExpr: {
+                auto cond = read<ast::Expr>();
+                auto if_true = read<ast::Expr>();
+                node = make_ptr<ast::IfExpr>(loc, std::move(cond), std::move(if_true), read_opt<ast::Expr>());
+                break;
+            }
+            case NodeKind::CaseExpr: {
+                auto ptrn = read<ast::Ptrn>();
+                node = make_ptr<ast::CaseExpr>(loc, std::move(ptrn), read<ast::Expr>());
+                break;
+            }
+            case NodeKind::MatchExpr: {
+                auto arg = read<ast::Expr>();
+                node = make_ptr<ast::MatchExpr>(loc, std::move(arg), read_nodes<ast::CaseExpr>());
+                break;
+            }
+            case NodeKind::WhileExpr: {
+                auto cond = read<ast::Expr>();
+                node = make_ptr<ast::WhileExpr>(loc, std::move(cond), read<ast::Expr>());
+                break;
+            }
+            case NodeKind::ForExpr: {
+                // The call has the form `(range(|i| { ... }))(0, 10)`, which later passes rely on
+                auto call = read<ast::CallExpr>();
+                auto inner_call = valid ? call->callee->isa<ast::CallExpr>() : nullptr;
+                valid &= inner_call && inner_call->arg->isa<ast::FnExpr>();
+                node = make_ptr<ast::ForExpr>(loc, std::move(call));
+                break;
+            }
+            case NodeKind::BreakExpr: {
+                node = make_ptr<ast::BreakExpr>(loc);
+                break;
+            }
+            case NodeKind::ContinueExpr: {
+                node = make_ptr<ast::ContinueExpr>(loc);
+                break;
+            }
+            case NodeKind::ReturnExpr: {
+                node = make_ptr<ast::ReturnExpr>(loc);
+                break;
+            }
+            case NodeKind::UnaryExpr: {
+                auto tag = read_enum(ast::UnaryExpr::Error);
+                node = make_ptr<ast::UnaryExpr>(loc, tag, read<ast::Expr>());
+                break;
+            }
+            case NodeKind::BinaryExpr: {
+                auto tag = read_enum(ast::BinaryExpr::Error);
+                auto left = read<ast::Expr>();
+                node = make_ptr<ast::BinaryExpr>(loc, tag, std::move(left), read<ast::Expr>());
+                break;
+            }
+            case NodeKind::FilterExpr: {
+                auto filter = read<ast::Filter>();
+                node = make_ptr<ast::FilterExpr>(loc, std::move(filter), read<ast::Expr>());
+                break;
+            }
+            case NodeKind::CastExpr: {
+                auto expr = read<ast::Expr>();
+                node = make_ptr<ast::CastExpr>(loc, std::move(expr), read<ast::Type>());
+                break;
+            }
+            case NodeKind::AsmExpr: {
+                auto src = read_str();
+                auto ins = read_constrs();
+                auto outs = read_constrs();
+                auto clobs = read_strs();
+                node = make_ptr<ast::AsmExpr>(loc, std::move(src), std::move(ins), std::move(outs), std::move(clobs), read_strs());
+                break;
+            }
+            case NodeKind::ErrorExpr: {
+                node = make_ptr<ast::ErrorExpr>(loc);
+                break;
+            }
+            // Declarations
+            case NodeKind::TypeParam: {
+                node = make_ptr<ast::TypeParam>(loc, read_id());
+                break;
+            }
+            case NodeKind::TypeParamList: {
+                node = make_ptr<ast::TypeParamList>(loc, read_nodes<ast::TypeParam>());
+                break;
+            }
+            case NodeKind::PtrnDecl: {
+                auto id = read_id();
+                node = make_ptr<ast::PtrnDecl>(loc, std::move(id), read_bool());
+                break;
+            }
+            case NodeKind::LetDecl: {
+                auto ptrn = read<ast::Ptrn>();
+                node = make_ptr<ast::LetDecl>(loc, std::move(ptrn), read_opt<ast::Expr>());
+                break;
+            }
+            case NodeKind::StaticDecl: {
+                auto id = read_id();
+                auto type = read_opt<ast::Type>();
+                auto init = read_opt<ast::Expr>();
+                node = make_ptr<ast::StaticDecl>(loc, std::move(id), std::move(type), std::move(init), read_bool());
+                break;
+            }
+            case NodeKind::FnDecl: {
+                auto id = read_id();
+                auto fn = read<ast::FnExpr>();
+                node = make_ptr<ast::FnDecl>(loc, std::move(id), std::move(fn), read_opt<ast::TypeParamList>());
+                break;
+            }
+            case NodeKind::FieldDecl: {
+                auto id = read_id();
+                auto type = read<ast::Type>();
+                node = make_ptr<ast::FieldDecl>(loc, std::move(id), std::move(type), read_opt<ast::Expr>());
+                break;
+            }
+            case NodeKind::StructDecl: {
+                auto id = read_id();
+                auto type_params = read_opt<ast::TypeParamList>();
+                node = make_ptr<ast::StructDecl>(loc, std::move(id), std::move(type_params), read_nodes<ast::FieldDecl>());
+                break;
+            }
+            case NodeKind::OptionDecl: {
+                auto id = read_id();
+                node = make_ptr<ast::OptionDecl>(loc, std::move(id), read_opt<ast::Type>());
+                break;
+            }
+            case NodeKind::EnumDecl: {
+                auto id = read_id();
+                auto type_params = read_opt<ast::TypeParamList>();
+                node = make_ptr<ast::EnumDecl>(loc, std::move(id), std::move(type_params), read_nodes<ast::OptionDecl>());
+                break;
+            }
+            case NodeKind::TypeDecl: {
+                auto id = read_id();
+                auto type_params = read_opt<ast::TypeParamList>();
+                node = make_ptr<ast::TypeDecl>(loc, std::move(id), std::move(type_params), read<ast::Type>());
+                break;
+            }
+            case NodeKind::ModDecl: {
+                auto id = read_id();
+                node = make_ptr<ast::ModDecl>(loc, std::move(id), read_nodes<ast::Decl>());
+                break;
+            }
+            case NodeKind::ErrorDecl: {
+                node = make_ptr<ast::ErrorDecl>(loc);
+                break;
+            }
+            // Patterns
+            case NodeKind::TypedPtrn: {
+                // Parameters of prototypes may only have a type
+                auto ptrn = read_opt<ast::Ptrn>();
+                node = make_ptr<ast::TypedPtrn>(loc, std::move(ptrn), read<ast::Type>());
+                break;
+            }
+            case NodeKind::IdPtrn: {
+                auto decl = read<ast::PtrnDecl>();
+                node = make_ptr<ast::IdPtrn>(loc, std::move(decl), read_opt<ast::Ptrn>());
+                break;
+            }
+            case NodeKind::LiteralPtrn: {
+                node = make_ptr<ast::LiteralPtrn>(loc, read_lit());
+                break;
+            }
+            case NodeKind::FieldPtrn: {
+                // Only the `...` field has no pattern
+                auto id = read_id();
+                auto ptrn = read_opt<ast::Ptrn>();
+                valid &= (ptrn == nullptr) == (id.name == "...");
+                node = make_ptr<ast::FieldPtrn>(loc, std::move(id), std::move(ptrn));
+                break;
+            }
+            case NodeKind::StructPtrn: {
+                auto path = read_path();
+                node = make_ptr<ast::StructPtrn>(loc, std::move(path), read_nodes<ast::FieldPtrn>());
+                break;
+            }
+            case NodeKind::EnumPtrn: {
+                auto path = read_path();
+                node = make_ptr<ast::EnumPtrn>(loc, std::move(path), read_opt<ast::Ptrn>());
+                break;
+            }
+            case NodeKind::TuplePtrn: {
+                node = make_ptr<ast::TuplePtrn>(loc, read_nodes<ast::Ptrn>());
+                break;
+            }
+            case NodeKind::ErrorPtrn: {
+                node = make_ptr<ast::ErrorPtrn>(loc);
+                break;
+            }
+            // Filters
+            case NodeKind::Filter: {
+                node = make_ptr<ast::Filter>(loc, read_opt<ast::Expr>());
+                break;
+            }
+            default:
+                assert(false);
+                return nullptr;
+        }
+        node->attrs = read_opt<ast::AttrList>();
+        if (auto decl = node->isa<ast::Decl>())
+            decl->is_top_level = read_bool();
+        return node;
+    }
+};
+
+std::string ModuleFile::write(
+    const std::vector<std::string>& files,
+    const std::vector<std::string_view>& contents,
+    const std::vector<const ast::Decl*>& decls)
+{
+    ModuleWriter writer;
+    for (auto& file : files)
+        writer.add_file(file);
+    writer.write_int(decls.size());
+    for (auto decl : decls)
+        writer.write_node(decl);
+
+    // Locations are read after the files they refer to, which are only known once all the nodes are written
+    ModuleWriter file_writer;
+    file_writer.write_int(writer.files.size());
+    for (size_t i = 0; i < writer.files.size(); ++i) {
+        file_writer.write_str(writer.files[i]);
+        file_writer.write_str(i < contents.size() ? contents[i] : std::string_view());
+    }
+    auto payload = file_writer.data + writer.data;
+
+    std::string data(magic, sizeof(magic));
+    write_fixed(data, version, sizeof(uint32_t));
+    write_fixed(data, fnv::Hash().combine(payload), sizeof(uint64_t));
+    return data + payload;
+}
+
+std::unique_ptr<ModuleFile> ModuleFile::read(std::string_view data) {
+    if (data.size() < header_size ||
+        data.compare(0, sizeof(magic), std::string_view(magic, sizeof(magic))) != 0 ||
+        read_fixed(data, sizeof(magic), sizeof(uint32_t)) != version)
+        return nullptr;
+    auto payload = data.substr(header_size);
+    if (read_fixed(data, sizeof(magic) + sizeof(uint32_t), sizeof(uint64_t)) != uint64_t(fnv::Hash().combine(payload)))
+        return nullptr;
+
+    ModuleReader reader(payload);
+    auto module = std::make_unique<ModuleFile>();
+    for (size_t i = 0, n = reader.read_count(); i < n; ++i) {
+        module->files.push_back(reader.read_str());
+        module->contents.push_back(reader.read_str());
+        reader.files.push_back(std::make_shared<std::string>(module->files.back()));
+    }
+    for (size_t i = 0, n = reader.read_count(); i < n && reader.valid; ++i) {
+        auto decl = reader.read<ast::Decl>();
+        reader.valid &= decl != nullptr;
+        module->decls.push_back(std::move(decl));
+    }
+    if (!reader.valid || reader.pos != payload.size())
+        return nullptr;
+    return module;
+}
+
+} // namespace artic
@@ -7,7 +7,14 @@
 namespace artic {
 
 Parser::Parser(Log& log, Lexer& lexer)
-    : Logger(log), lexer_(lexer)
+    : Logger(log), lexer_(&lexer)
+{
+    for (int i = 0; i < max_ahead; i++)
+        next();
+}
+
+Parser::Parser(Log& log, std::vector<Token>&& tokens)
+    : Logger(log), lexer_(nullptr), tokens_(std::move(tokens))
 {
     for (int i = 0; i < max_ahead; i++)
         next();
@@ -21,6 +28,10 @@ Ptr<ast::ModDecl> Parser::parse() {
     return make_ptr<ast::ModDecl>(tracker(), ast::Identifier(), std::move(decls));
 }
 
+Ptr<ast::BlockExpr> Parser::parse_lazy_body() {
+    return parse_block_expr();
+}
+
 // Declarations --------------------------------------------------------------------
 
 Ptr<ast::Decl> Parser::parse_decl(bool is_top_level) {
@@ -36,7 +47,7 @@ Ptr<ast::Decl> Parser::parse_decl(bool is_top_level) {
                 note("use a static variable instead");
             }
             break;
-        case Token::Fn:     decl = parse_fn_decl();     break;
+        case Token::Fn:     decl = parse_fn_decl(is_top_level); break;
         case Token::Struct: decl = parse_struct_decl(); break;
         case Token::Enum:   decl = parse_enum_decl();   break;
         case Token::Type:   decl = parse_type_decl();   break;
@@ -62,7 +73,7 @@ Ptr<ast::LetDecl> Parser::parse_let_decl() {
     return make_ptr<ast::LetDecl>(tracker(), std::move(ptrn), std::move(init));
 }
 
-Ptr<ast::FnDecl> Parser::parse_fn_decl() {
+Ptr<ast::FnDecl> Parser::parse_fn_decl(bool is_top_level) {
     Tracker tracker(this);
     eat(Token::Fn);
 
@@ -88,30 +99,58 @@ Ptr<ast::FnDecl> Parser::parse_fn_decl() {
         ret_type = parse_type();
 
     Ptr<ast::Expr> body;
-    if (ahead().tag() == Token::LBrace)
+    std::vector<Token> lazy_body;
+    if (ahead().tag() == Token::LBrace && is_top_level && lazy_fn_bodies) {
+        // Only record the tokens up to the matching brace
+        size_t depth = 0;
+        do {
+            if (ahead().tag() == Token::LBrace)
+                depth++;
+            else if (ahead().tag() == Token::RBrace)
+                depth--;
+            lazy_body.push_back(ahead());
+            next();
+        } while (depth > 0 && ahead().tag() != Token::End);
+        // Unbalanced braces are reported right away, instead of silently swallowing the rest of the file
+        if (depth > 0) {
+            Parser parser(log, std::move(lazy_body));
+            parser.warns_as_errors = warns_as_errors;
+            body = parser.parse_lazy_body();
+            errors += parser.errors;
+            warns += parser.warns;
+            lazy_body.clear();
+        }
+    } else if (ahead().tag() == Token::LBrace)
         body = parse_block_expr();
     else if (accept(Token::Eq))
         body = parse_expr();
 
-    if (!body) {
+    if (!body && lazy_body.empty()) {
         if (!ret_type)
             error(ahead().loc(), "return type expected for function prototype");
         expect(Token::Semi);
     }
 
     auto fn = make_ptr<ast::FnExpr>(tracker(), std::move(filter), std::move(param), std::move(ret_type), std::move(body));
-    return make_ptr<ast::FnDecl>(tracker(), std::move(id), std::move(fn), std::move(type_params));
+    auto fn_decl = make_ptr<ast::FnDecl>(tracker(), std::move(id), std::move(fn), std::move(type_params));
+    fn_decl->lazy_body = std::move(lazy_body);
+    return fn_decl;
 }
 
 Ptr<ast::FieldDecl> Parser::parse_field_decl() {
     Tracker tracker(this);
+    Ptr<ast::AttrList> attrs;
+    if (ahead().tag() == Token::Hash)
+        attrs = parse_attr_list();
     auto id = parse_id();
     expect(Token::Colon);
     auto type = parse_type();
     Ptr<ast::Expr> init;
     if (accept(Token::Eq))
         init = parse_expr();
-    return make_ptr<ast::FieldDecl>(tracker(), std::move(id), std::move(type), std::move(init));
+    auto field = make_ptr<ast::FieldDecl>(tracker(), std::move(id), std::move(type), std::move(init));
+    field->attrs = std::move(attrs);
+    return field;
 }
 
 Ptr<ast::StructDecl> Parser::parse_struct_decl() {
@@ -212,8 +251,11 @@ Ptr<ast::ModDecl> Parser::parse_mod_decl() {
     auto id = parse_id();
     PtrVector<ast::Decl> decls;
     expect(Token::LBrace);
+    // Lazy bodies are only bound at the top level of the program, where the name binder looks for them
+    auto lazy_fn_bodies = std::exchange(this->lazy_fn_bodies, false);
     while (ahead().tag() != Token::End && ahead().tag() != Token::RBrace)
         decls.emplace_back(parse_decl(true));
+    this->lazy_fn_bodies = lazy_fn_bodies;
     expect(Token::RBrace);
     return make_ptr<ast::ModDecl>(tracker(), std::move(id), std::move(decls));
 }
@@ -369,18 +411,31 @@ Ptr<ast::ErrorPtrn> Parser::parse_error_ptrn() {
 // Statements ----------------------------------------------------------------------
 
 Ptr<ast::Stmt> Parser::parse_stmt() {
-    if (ahead().tag() == Token::Let || ahead().tag() == Token::Fn)
-        return parse_decl_stmt();
     Tracker tracker(this);
+    Ptr<ast::AttrList> attrs;
+    if (ahead().tag() == Token::Hash)
+        attrs = parse_attr_list();
+    if (ahead().tag() == Token::Let || ahead().tag() == Token::Fn) {
+        auto stmt = parse_decl_stmt();
+        if (attrs)
+            stmt->decl->attrs = std::move(attrs);
+        return stmt;
+    }
     Ptr<ast::Expr> expr;
     switch (ahead().tag()) {
         case Token::If:    expr = parse_if_expr();    break;
         case Token::Match: expr = parse_match_expr(); break;
         case Token::For:   expr = parse_for_expr();   break;
         case Token::While: expr = parse_while_expr(); break;
-        default:
-            return parse_expr_stmt();
+        default: {
+            auto stmt = parse_expr_stmt();
+            if (attrs)
+                stmt->expr->attrs = std::move(attrs);
+            return stmt;
+        }
     }
+    // Attributes on statements are attached to the expression (e.g. loop hints)
+    expr->attrs = std::move(attrs);
     return make_ptr<ast::ExprStmt>(tracker(), std::move(expr));
 }
 
@@ -530,6 +585,7 @@ Ptr<ast::BlockExpr> Parser::parse_block_expr() {
             case Token::Simd:
             case Token::Let:
             case Token::Fn:
+            case Token::Hash:
                 if (!last_semi && !stmts.empty() && stmts.back()->needs_semicolon())
                     error(ahead().loc(), "expected ';', but got '{}'", ahead().string());
                 last_semi = false;
@@ -971,11 +1027,12 @@ Ptr<ast::PtrType> Parser::parse_ptr_type() {
     Tracker tracker(this);
     eat(Token::And);
     bool is_mut = accept(Token::Mut);
+    bool is_noalias = accept(Token::NoAlias);
     size_t addr_space = 0;
     if (ahead().tag() == Token::AddrSpace)
         addr_space = parse_addr_space();
     auto pointee = parse_type();
-    return make_ptr<ast::PtrType>(tracker(), std::move(pointee), is_mut, addr_space);
+    return make_ptr<ast::PtrType>(tracker(), std::move(pointee), is_mut, is_noalias, addr_space);
 }
 
 Ptr<ast::TypeApp> Parser::parse_type_app() {
@@ -1025,9 +1082,15 @@ Ptr<ast::Attr> Parser::parse_attr() {
             auto lit = ahead().literal();
             eat(Token::Lit);
             return make_ptr<ast::LiteralAttr>(tracker(), std::move(name), lit);
-        } else if (ahead().tag() == Token::Id) {
+        } else if (ahead().tag() == Token::Id && ast::PrimType::tag_from_token(ahead()) == ast::PrimType::Error) {
             auto path = parse_path();
             return make_ptr<ast::PathAttr>(tracker(), std::move(name), std::move(path));
+        } else if (
+            ahead().tag() == Token::Id       || ahead().tag() == Token::And    ||
+            ahead().tag() == Token::LParen   || ahead().tag() == Token::Fn     ||
+            ahead().tag() == Token::LBracket || ahead().tag() == Token::Simd) {
+            auto type = parse_type();
+            return make_ptr<ast::TypeAttr>(tracker(), std::move(name), std::move(type));
         } else {
             error(ahead().loc(), "expected attribute value, got '{}'", ahead().string());
             return make_ptr<ast::NamedAttr>(tracker(), std::move(name), PtrVector<ast::Attr>());
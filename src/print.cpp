@@ -59,6 +59,11 @@ void PathAttr::print(Printer& p) const {
     path.print(p);
 }
 
+void TypeAttr::print(Printer& p) const {
+    p << name << " = ";
+    type->print(p);
+}
+
 void LiteralAttr::print(Printer& p) const {
     p << name << " = " << std::showpoint << log::literal_style(lit);
 }
@@ -175,6 +180,7 @@ void FnExpr::print(Printer& p) const {
 }
 
 void BlockExpr::print(Printer& p) const {
+    if (attrs) attrs->print(p);
     if (stmts.empty())
         p << "{}";
     else {
@@ -234,6 +240,7 @@ void MatchExpr::print(Printer& p) const {
 }
 
 void WhileExpr::print(Printer& p) const {
+    if (attrs) attrs->print(p);
     p << log::keyword_style("while") << ' ';
     cond->print(p);
     p << ' ';
@@ -243,6 +250,7 @@ void WhileExpr::print(Printer& p) const {
 void ForExpr::print(Printer& p) const {
     auto& iter = call->callee->as<ast::CallExpr>()->callee;
     auto lambda = call->callee->as<ast::CallExpr>()->arg->as<ast::FnExpr>();
+    if (attrs) attrs->print(p);
     p << log::keyword_style("for") << ' ';
     lambda->param->print(p);
     p << ' ' << log::keyword_style("in") << ' ';
@@ -470,6 +478,7 @@ void FnDecl::print(Printer& p) const {
 }
 
 void FieldDecl::print(Printer& p) const {
+    if (attrs) attrs->print(p);
     p << id.name << ": ";
     type->print(p);
     if (init) {
@@ -579,6 +588,8 @@ void PtrType::print(Printer& p) const {
     p << '&';
     if (is_mut)
         p << log::keyword_style("mut") << ' ';
+    if (is_noalias)
+        p << log::keyword_style("noalias") << ' ';
     if (addr_space != 0)
         p << log::keyword_style("addrspace") << '(' << addr_space << ')';
     if (pointee->isa<PtrType>())
@@ -642,6 +653,8 @@ void PtrType::print(Printer& p) const {
     p << '&';
     if (is_mut)
         p << log::keyword_style("mut") << ' ';
+    if (is_noalias)
+        p << log::keyword_style("noalias") << ' ';
     if (addr_space != 0)
         p << log::keyword_style("addrspace") << '(' << addr_space << ')';
     if (pointee->isa<PtrType>())
@@ -53,6 +53,10 @@ bool AddrType::equals(const Type* other) const {
         other->as<AddrType>()->is_mut == is_mut;
 }
 
+bool PtrType::equals(const Type* other) const {
+    return AddrType::equals(other) && other->as<PtrType>()->is_noalias == is_noalias;
+}
+
 bool FnType::equals(const Type* other) const {
     return
         other->isa<FnType>() &&
@@ -129,6 +133,10 @@ size_t AddrType::hash() const {
         .combine(is_mut);
 }
 
+size_t PtrType::hash() const {
+    return fnv::Hash().combine(AddrType::hash()).combine(is_noalias);
+}
+
 size_t FnType::hash() const {
     return fnv::Hash()
         .combine(typeid(*this).hash_code())
@@ -220,7 +228,7 @@ const Type* UnsizedArrayType::replace(const std::unordered_map<const TypeVar*, c
 }
 
 const Type* PtrType::replace(const std::unordered_map<const TypeVar*, const Type*>& map) const {
-    return type_table.ptr_type(pointee->replace(map), is_mut, addr_space);
+    return type_table.ptr_type(pointee->replace(map), is_mut, addr_space, is_noalias);
 }
 
 const Type* RefType::replace(const std::unordered_map<const TypeVar*, const Type*>& map) const {
@@ -474,20 +482,23 @@ bool Type::subtype(const Type* other) const {
             ptr_type && ptr_type->addr_space == other_ptr_type->addr_space) {
             // &U <: &T if U <: T
             // &mut U <: &T if U <: T
+            // `noalias` is a promise made by the programmer, and
+            // can be added to or removed from any pointer:
+            // &noalias U <: &T and &U <: &noalias T if U <: T
             if ((ptr_type->is_mut || !other_ptr_type->is_mut) &&
                 ptr_type->pointee->subtype(other_ptr_type->pointee))
                 return true;
-            // &[T * N] <: &[T]
+            // &[T * N] <: &[T] (unless T is a `#[soa]` structure)
             if (auto other_array_type = other_ptr_type->pointee->isa<UnsizedArrayType>()) {
                 if (auto sized_array_type = ptr_type->pointee->isa<SizedArrayType>())
-                    return sized_array_type->elem == other_array_type->elem && !sized_array_type->is_simd;
+                    return sized_array_type->elem == other_array_type->elem && !sized_array_type->is_simd && !is_soa_type(sized_array_type->elem);
             }
         }
         // [T * N] <: &[T] (only valid for generic pointers)
         if (auto other_array_type = other_ptr_type->pointee->isa<UnsizedArrayType>();
             other_ptr_type->addr_space == 0 && other_array_type) {
             if (auto sized_array_type = isa<SizedArrayType>())
-                return sized_array_type->elem == other_array_type->elem && !sized_array_type->is_simd;
+                return sized_array_type->elem == other_array_type->elem && !sized_array_type->is_simd && !is_soa_type(sized_array_type->elem);
         }
     } else if (auto tuple_type = isa<TupleType>()) {
         if (auto other_tuple_type = other->isa<TupleType>();
@@ -592,6 +603,11 @@ bool is_unit_type(const Type* type) {
     return type->isa<TupleType>() && type->as<TupleType>()->args.empty();
 }
 
+bool is_soa_type(const Type* type) {
+    auto [_, struct_type] = match_app<StructType>(type);
+    return struct_type && struct_type->decl.attrs && struct_type->decl.attrs->find("soa");
+}
+
 // Type table ----------------------------------------------------------------------
 
 TypeTable::~TypeTable() {
@@ -623,8 +639,8 @@ const UnsizedArrayType* TypeTable::unsized_array_type(const Type* elem) {
     return insert<UnsizedArrayType>(elem);
 }
 
-const PtrType* TypeTable::ptr_type(const Type* pointee, bool is_mut, size_t addr_space) {
-    return insert<PtrType>(pointee, is_mut, addr_space);
+const PtrType* TypeTable::ptr_type(const Type* pointee, bool is_mut, size_t addr_space, bool is_noalias) {
+    return insert<PtrType>(pointee, is_mut, addr_space, is_noalias);
 }
 
 const RefType* TypeTable::ref_type(const Type* pointee, bool is_mut, size_t addr_space) {
@@ -684,12 +700,28 @@ const Type* TypeTable::type_app(const UserType* applied, std::vector<const Type*
     return insert<TypeApp>(applied, std::move(type_args));
 }
 
+void TypeTable::rollback(size_t checkpoint) {
+    // Types only refer to types that have been created before them
+    while (order_.size() > checkpoint) {
+        auto type = order_.back();
+        order_.pop_back();
+        types_.erase(type);
+        if (type == unit_type_)   unit_type_   = nullptr;
+        if (type == bottom_type_) bottom_type_ = nullptr;
+        if (type == top_type_)    top_type_    = nullptr;
+        if (type == no_ret_type_) no_ret_type_ = nullptr;
+        if (type == type_error_)  type_error_  = nullptr;
+        delete type;
+    }
+}
+
 template <typename T, typename... Args>
 const T* TypeTable::insert(Args&&... args) {
     T t(*this, std::forward<Args>(args)...);
     if (auto it = types_.find(&t); it != types_.end())
         return (*it)->template as<T>();
     auto [it, _] = types_.emplace(new T(std::move(t)));
+    order_.push_back(*it);
     return (*it)->template as<T>();
 }
 
@@ -6,3 +6,9 @@ execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${TEST_NAME}.out ${TES
 if (NOT status STREQUAL "0")
     message(FATAL_ERROR "Reference does not match test output")
 endif ()
+if (TEST_CACHE_STATS)
+    execute_process(COMMAND ${TEST_CACHE_STATS} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+    if (NOT status STREQUAL "0" OR NOT output MATCHES "cache hits: 1/2")
+        message(FATAL_ERROR "The second compilation is not restored from the cache:\n${output}")
+    endif ()
+endif ()
@@ -0,0 +1,55 @@
+# Compiles the same program twice through one compiler server, which keeps the library in memory,
+# and checks that the generated files are identical to the ones of a direct compilation.
+# Each compilation runs in its own directory, since the name of the module appears in the LLVM IR.
+set(base ${CMAKE_CURRENT_BINARY_DIR}/${TEST_NAME})
+set(socket ${base}.sock)
+file(REMOVE ${socket})
+foreach (dir direct daemon_1 daemon_2)
+    file(REMOVE_RECURSE ${base}_${dir})
+    file(MAKE_DIRECTORY ${base}_${dir})
+endforeach ()
+
+execute_process(COMMAND sh -c "\"${TEST_COMPILER}\" --daemon \"${socket}\" > /dev/null 2>&1 & echo $!"
+    OUTPUT_VARIABLE pid OUTPUT_STRIP_TRAILING_WHITESPACE)
+# Clients compile locally when the server cannot be reached, so the socket must exist before they run
+foreach (attempt RANGE 50)
+    if (EXISTS ${socket})
+        break ()
+    endif ()
+    execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.1)
+endforeach ()
+if (NOT EXISTS ${socket})
+    execute_process(COMMAND kill ${pid})
+    message(FATAL_ERROR "The compiler server does not listen on \"${socket}\"")
+endif ()
+
+foreach (dir direct daemon_1 daemon_2)
+    set(connect)
+    if (NOT dir STREQUAL "direct")
+        set(connect --connect ${socket})
+    endif ()
+    execute_process(
+        COMMAND ${TEST_COMPILER} ${connect} --library ${TEST_LIBRARY} ${TEST_SOURCE} --emit-llvm -o ${TEST_NAME}
+        WORKING_DIRECTORY ${base}_${dir}
+        RESULT_VARIABLE status)
+    if (NOT status STREQUAL "0")
+        execute_process(COMMAND kill ${pid})
+        message(FATAL_ERROR "Error compiling \"${TEST_SOURCE}\" (${dir}): ${status}")
+    endif ()
+endforeach ()
+
+# The server must still be running, otherwise the second client may have compiled the program locally
+execute_process(COMMAND kill ${pid} RESULT_VARIABLE status)
+file(REMOVE ${socket})
+if (NOT status STREQUAL "0")
+    message(FATAL_ERROR "The compiler server has stopped while compiling \"${TEST_SOURCE}\"")
+endif ()
+
+foreach (run 1 2)
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E compare_files ${base}_direct/${TEST_NAME}.ll ${base}_daemon_${run}/${TEST_NAME}.ll
+        RESULT_VARIABLE status)
+    if (NOT status STREQUAL "0")
+        message(FATAL_ERROR "Compiling through the compiler server produces a different output (run ${run})")
+    endif ()
+endforeach ()
@@ -0,0 +1,9 @@
+# Compiles a program to LLVM IR and checks the result against the CHECK lines of the program
+execute_process(COMMAND ${TEST_COMPILER} ${TEST_SOURCE} ${TEST_ARGS} --emit-llvm -o ${TEST_NAME} RESULT_VARIABLE status)
+if (NOT status STREQUAL "0")
+    message(FATAL_ERROR "Error compiling \"${TEST_SOURCE}\": ${status}")
+endif ()
+execute_process(COMMAND ${TEST_FILECHECK} ${TEST_SOURCE} --input-file ${TEST_NAME}.ll RESULT_VARIABLE status)
+if (NOT status STREQUAL "0")
+    message(FATAL_ERROR "Generated LLVM IR does not match the CHECK lines of \"${TEST_SOURCE}\"")
+endif ()
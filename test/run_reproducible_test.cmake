@@ -0,0 +1,26 @@
+# Compiles the same program twice and checks that the generated files are identical.
+# The extensions of the files to compare are given in TEST_OUTPUTS (by default, only the LLVM IR).
+# Each compilation runs in its own directory, since the name of the module appears in the LLVM IR.
+if (NOT TEST_OUTPUTS)
+    set(TEST_OUTPUTS .ll)
+endif ()
+set(base ${CMAKE_CURRENT_BINARY_DIR}/${TEST_NAME})
+foreach (run 1 2)
+    file(REMOVE_RECURSE ${base}_${run})
+    file(MAKE_DIRECTORY ${base}_${run})
+    execute_process(
+        COMMAND ${TEST_COMPILER} ${TEST_SOURCE} --emit-llvm -o ${TEST_NAME}
+        WORKING_DIRECTORY ${base}_${run}
+        RESULT_VARIABLE status)
+    if (NOT status STREQUAL "0")
+        message(FATAL_ERROR "Error compiling \"${TEST_SOURCE}\": ${status}")
+    endif ()
+endforeach ()
+foreach (output ${TEST_OUTPUTS})
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E compare_files ${base}_1/${TEST_NAME}${output} ${base}_2/${TEST_NAME}${output}
+        RESULT_VARIABLE status)
+    if (NOT status STREQUAL "0")
+        message(FATAL_ERROR "Compiling the same program twice produces different outputs (\"${output}\")")
+    endif ()
+endforeach ()